@@ -0,0 +1,283 @@
+#include "ecs.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <span>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Microbenchmarks of core operations, results are printed to stdout as JSON:
+//     yaecs_bench [max_entities = 10000000] [repeats = 5]
+// Every benchmark is run once for warm up, then repeats times, samples are wall time of one run
+
+#ifndef YAECS_BENCH_VERSION
+#define YAECS_BENCH_VERSION "unknown"
+#endif
+
+struct Position { float x, y, z; };
+struct Velocity { float x, y, z; };
+struct Acceleration { float x, y, z; };
+struct Health { int value; };
+
+class EmptySystem : public ecs::System, public ecs::IRunSystem {
+public:
+    EmptySystem() { _access.AddRead<Health>(); }
+    void run() override { }
+};
+template <size_t Index>
+class IndexedEmptySystem final : public EmptySystem { };
+
+class MoveSystem : public ecs::BaseSystem<Position, ecs::Read<Velocity>> {
+public:
+    void run() override {
+        world().View<Position, const Velocity>().Each([](Position& position, const Velocity& velocity) {
+            position.x += velocity.x;
+            position.y += velocity.y;
+            position.z += velocity.z;
+        });
+    }
+};
+
+static volatile float sink = 0;
+
+class Report {
+public:
+    struct Result {
+        std::string name;
+        size_t entities;
+        size_t operations; // per run
+        std::vector<double> samples; // ns per run
+    };
+
+    explicit Report(size_t repeats) : _repeats{repeats} { }
+
+    template <typename Func>
+    void Add(const std::string& name, const size_t entities, const size_t operations, Func func) {
+        func(); // warm up
+        Result result{name, entities, operations, {}};
+        for (size_t repeat = 0; repeat < _repeats; repeat++) {
+            auto begin = std::chrono::steady_clock::now();
+            func();
+            auto end = std::chrono::steady_clock::now();
+            result.samples.push_back(std::chrono::duration<double, std::nano>(end - begin).count());
+        }
+        _results.push_back(std::move(result));
+        std::cerr << name << " " << entities << " done" << std::endl;
+    }
+
+    void Print(std::ostream& out) const {
+        out << "{\n  \"version\": \"" << YAECS_BENCH_VERSION << "\",\n";
+        out << "  \"repeats\": " << _repeats << ",\n";
+        out << "  \"threads\": " << ecs::ThreadPool::Shared().GetThreadsCount() << ",\n";
+        out << "  \"benchmarks\": [\n";
+        for (size_t index = 0; index < _results.size(); index++) {
+            const Result& result = _results[index];
+            std::vector<double> sorted = result.samples;
+            std::sort(sorted.begin(), sorted.end());
+            const double median = sorted[sorted.size() / 2];
+            const double operations = static_cast<double>(std::max<size_t>(result.operations, 1));
+
+            out << "    {\"name\": \"" << result.name << "\", \"entities\": " << result.entities
+                << ", \"operations\": " << result.operations
+                << ", \"min_ns\": " << sorted.front() << ", \"median_ns\": " << median << ", \"max_ns\": " << sorted.back()
+                << ", \"median_ns_per_op\": " << median / operations << "}"
+                << (index + 1 < _results.size() ? ",\n" : "\n");
+        }
+        out << "  ]\n}\n";
+    }
+
+private:
+    size_t _repeats;
+    std::vector<Result> _results{};
+};
+
+void BenchEntities(Report& report, const size_t count) {
+    ecs::World world{static_cast<uint32_t>(count), 4};
+    std::vector<ecs::entity> entities(count);
+
+    report.Add("create_destroy", count, count * 2, [&]() {
+        for (auto& entity : entities) entity = world.CreateEntity();
+        for (auto entity : entities) world.DestroyEntity(entity);
+    });
+    report.Add("create_destroy_batch", count, count * 2, [&]() {
+        world.CreateEntities(entities.size(), entities);
+        world.DestroyEntities(entities);
+    });
+}
+
+void BenchComponents(Report& report, const size_t count) {
+    ecs::World world{static_cast<uint32_t>(count), 8};
+    world.RegisterComponent<Position>();
+    world.RegisterComponent<Velocity>();
+    world.RegisterComponent<Acceleration>();
+    world.RegisterComponent<Health>();
+
+    std::vector<ecs::entity> entities(count);
+    world.CreateEntities(entities.size(), entities);
+    world.InsertComponents(entities, Position{0, 0, 0});
+    world.InsertComponents(entities, Velocity{1, 1, 1});
+    world.InsertComponents(entities, Acceleration{0.5f, 0.5f, 0.5f});
+
+    report.Add("add_remove", count, count * 2, [&]() {
+        for (auto entity : entities) world.InsertComponent(entity, Health{100});
+        for (auto entity : entities) world.RemoveComponent<Health>(entity);
+    });
+
+    report.Add("iterate_1", count, count, [&]() {
+        world.View<Position>().Each([](Position& position) { position.x += 1; });
+    });
+    report.Add("iterate_2", count, count, [&]() {
+        world.View<Position, const Velocity>().Each([](Position& position, const Velocity& velocity) {
+            position.x += velocity.x;
+            position.y += velocity.y;
+            position.z += velocity.z;
+        });
+    });
+    report.Add("iterate_3", count, count, [&]() {
+        world.View<Position, Velocity, const Acceleration>().Each(
+            [](Position& position, Velocity& velocity, const Acceleration& acceleration) {
+                velocity.x += acceleration.x;
+                velocity.y += acceleration.y;
+                velocity.z += acceleration.z;
+                position.x += velocity.x;
+                position.y += velocity.y;
+                position.z += velocity.z;
+            });
+    });
+
+    std::vector<ecs::entity> shuffled = entities;
+    std::shuffle(shuffled.begin(), shuffled.end(), std::mt19937{42});
+    report.Add("random_get", count, count, [&]() {
+        float sum = 0;
+        for (auto entity : shuffled) sum += world.GetComponent<const Position>(entity).x;
+        sink = sum;
+    });
+
+    ecs::Systems systems{world};
+    auto run_systems = systems.CreateCollectionInterface<ecs::IRunSystem>();
+    auto init_systems = systems.CreateCollectionInterface<ecs::IInitSystem>();
+    auto move_system = systems.CreateSystem<MoveSystem>();
+    run_systems->AddSystem(move_system);
+    init_systems->AddSystem(move_system);
+    init_systems->execute();
+    report.Add("system_iterate_2", count, count, [&]() { run_systems->execute(); });
+
+    std::stringstream snapshot{};
+    world.SaveSnapshot(snapshot);
+    const std::string snapshot_bytes = snapshot.str();
+    ecs::World loaded{static_cast<uint32_t>(count), 8};
+    loaded.RegisterComponent<Position>();
+    loaded.RegisterComponent<Velocity>();
+    loaded.RegisterComponent<Acceleration>();
+    loaded.RegisterComponent<Health>();
+    report.Add("snapshot_save", count, count, [&]() {
+        std::stringstream out{};
+        world.SaveSnapshot(out);
+    });
+    report.Add("snapshot_load", count, count, [&]() {
+        loaded.LoadSnapshot(std::span{reinterpret_cast<const std::byte*>(snapshot_bytes.data()), snapshot_bytes.size()});
+    });
+
+    // velocities are inserted in other order than positions, so view jumps over velocity pool until it is sorted
+    ecs::World scattered{static_cast<uint32_t>(count), 8};
+    scattered.RegisterComponent<Position>();
+    scattered.RegisterComponent<Velocity>();
+    std::vector<ecs::entity> scattered_entities(count);
+    scattered.CreateEntities(scattered_entities.size(), scattered_entities);
+    scattered.InsertComponents(scattered_entities, Position{0, 0, 0});
+    std::shuffle(scattered_entities.begin(), scattered_entities.end(), std::mt19937{7});
+    for (auto entity : scattered_entities) scattered.InsertComponent(entity, Velocity{1, 1, 1});
+    auto iterate_scattered = [&]() {
+        scattered.View<Position, const Velocity>().Each([](Position& position, const Velocity& velocity) {
+            position.x += velocity.x;
+            position.y += velocity.y;
+            position.z += velocity.z;
+        });
+    };
+    report.Add("unsorted_iterate_2", count, count, iterate_scattered);
+    scattered.SortAs<Velocity, Position>();
+    report.Add("sorted_iterate_2", count, count, iterate_scattered);
+
+    // group reorders pools, so it goes last
+    auto& group = world.Group<Position, Velocity, Acceleration>();
+    report.Add("group_iterate_3", count, count, [&]() {
+        group.Each([](Position& position, Velocity& velocity, const Acceleration& acceleration) {
+            velocity.x += acceleration.x;
+            velocity.y += acceleration.y;
+            velocity.z += acceleration.z;
+            position.x += velocity.x;
+            position.y += velocity.y;
+            position.z += velocity.z;
+        });
+    });
+}
+
+void BenchStaticWorld(Report& report, const size_t count) {
+    ecs::StaticWorld<Position, Velocity, Acceleration, Health> world{static_cast<uint32_t>(count)};
+    std::vector<ecs::entity> entities(count);
+    world.CreateEntities(entities.size(), entities);
+    world.InsertComponents(std::span<const ecs::entity>(entities), Position{0, 0, 0});
+    world.InsertComponents(std::span<const ecs::entity>(entities), Velocity{1, 1, 1});
+
+    report.Add("static_iterate_2", count, count, [&]() {
+        world.View<Position, const Velocity>().Each([](Position& position, const Velocity& velocity) {
+            position.x += velocity.x;
+            position.y += velocity.y;
+            position.z += velocity.z;
+        });
+    });
+
+    std::vector<ecs::entity> shuffled = entities;
+    std::shuffle(shuffled.begin(), shuffled.end(), std::mt19937{42});
+    report.Add("static_random_get", count, count, [&]() {
+        float sum = 0;
+        for (auto entity : shuffled) sum += world.GetComponent<const Position>(entity).x;
+        sink = sum;
+    });
+}
+
+template <size_t... Indexes>
+void AddEmptySystems(ecs::Systems& systems, ecs::SystemCollection<ecs::IRunSystem>& collection, std::index_sequence<Indexes...>) {
+    (collection.AddSystem(systems.CreateSystem<IndexedEmptySystem<Indexes>>()), ...);
+}
+
+void BenchSystemsOverhead(Report& report) {
+    constexpr size_t systems_count = 16;
+    constexpr size_t executions = 1000;
+
+    ecs::World world{16, 4};
+    world.RegisterComponent<Health>();
+    ecs::Systems systems{world};
+    auto run_systems = systems.CreateCollectionInterface<ecs::IRunSystem>();
+    AddEmptySystems(systems, *run_systems, std::make_index_sequence<systems_count>{});
+
+    run_systems->SetThreadPool(nullptr);
+    report.Add("systems_overhead_sequential", 0, executions * systems_count, [&]() {
+        for (size_t i = 0; i < executions; i++) run_systems->execute();
+    });
+    run_systems->SetThreadPool(&ecs::ThreadPool::Shared());
+    report.Add("systems_overhead_parallel", 0, executions * systems_count, [&]() {
+        for (size_t i = 0; i < executions; i++) run_systems->execute();
+    });
+}
+
+int main(int argc, char* argv[]) {
+    const size_t max_entities = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 10'000'000;
+    const size_t repeats = argc > 2 ? std::max<size_t>(std::strtoull(argv[2], nullptr, 10), 1) : 5;
+
+    Report report{repeats};
+    for (size_t count : {10'000, 100'000, 1'000'000, 10'000'000}) {
+        if (count > max_entities) break;
+        BenchEntities(report, count);
+        BenchComponents(report, count);
+        BenchStaticWorld(report, count);
+    }
+    BenchSystemsOverhead(report);
+
+    report.Print(std::cout);
+    return 0;
+}
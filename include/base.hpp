@@ -4,6 +4,7 @@
 #include "utils.hpp"
 
 #include <cassert>
+#include <cstdint>
 #include <unordered_map>
 #include <unordered_set>
 #include <array>
@@ -11,9 +12,32 @@
 
 namespace ecs {
 
-    using entity = std::uint32_t;
+    // entity is index (low 32 bits) + version (high 32 bits),
+    // version increments each time the index is recycled, so stale handles can be detected
+    using entity = std::uint64_t;
+    using entity_index = std::uint32_t;
+    using entity_version = std::uint32_t;
+    // world time, advanced after every system run, components store ticks of last add/change
+    using tick = std::uint32_t;
     using component_index = std::uint32_t;
 
+    static const entity NULL_ENTITY = ~entity{0};
+    static const entity_index NULL_ENTITY_INDEX = ~entity_index{0};
+
+    [[nodiscard]] constexpr entity_index GetEntityIndex(const entity entity) {
+        return static_cast<entity_index>(entity);
+    }
+    [[nodiscard]] constexpr entity_version GetEntityVersion(const entity entity) {
+        return static_cast<entity_version>(entity >> 32);
+    }
+    [[nodiscard]] constexpr entity MakeEntity(const entity_index index, const entity_version version) {
+        return (static_cast<entity>(version) << 32) | index;
+    }
+
     static const uint32_t DEFAULT_ENTITIES_CAPACITY = 5000;
     static const uint32_t DEFAULT_ENTITY_CAPACITY = 32;
+
+    static constexpr size_t CACHE_LINE_SIZE = 64;
+    // minimal count of elements in one chunk of parallel iteration
+    static constexpr size_t DEFAULT_PARALLEL_GRAIN = 1024;
 }
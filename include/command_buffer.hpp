@@ -0,0 +1,152 @@
+#pragma once
+
+#include "base.hpp"
+#include "types.hpp"
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace ecs {
+
+    class World;
+
+    // Command Buffer
+    // Records structural changes (create/destroy entities, insert/remove components) to apply them
+    // later in World::Flush. Buffer isn't thread safe, use one buffer per thread or per system.
+    // Components are stored in linear arena of blocks, blocks are never moved and reused after clear()
+
+    class CommandBuffer {
+    public:
+        CommandBuffer() = default;
+        ~CommandBuffer() { clear(); }
+
+        CommandBuffer(CommandBuffer&& other) noexcept { *this = std::move(other); }
+        // recorded components of this buffer are destroyed, other is left empty
+        CommandBuffer& operator=(CommandBuffer&& other) noexcept {
+            if (this == &other) return *this;
+            clear();
+            _commands = std::exchange(other._commands, {});
+            _blocks = std::exchange(other._blocks, {});
+            _block = std::exchange(other._block, 0);
+            _block_offset = std::exchange(other._block_offset, 0);
+            _created_count = std::exchange(other._created_count, 0);
+            return *this;
+        }
+
+        CommandBuffer(const CommandBuffer&) = delete;
+        CommandBuffer& operator=(const CommandBuffer&) = delete;
+
+        // Entities created by buffer are pending until flush,
+        // they can be used only with commands of the same buffer
+        static constexpr entity_version PENDING_VERSION = ~entity_version{0};
+        [[nodiscard]] static bool IsPending(const entity entity) {
+            return GetEntityVersion(entity) == PENDING_VERSION;
+        }
+
+    public: // Commands
+
+        [[nodiscard]] entity CreateEntity() {
+            entity pending = MakeEntity(_created_count++, PENDING_VERSION);
+            _commands.push_back(Command{CommandType::Create, 0, pending, nullptr, nullptr, nullptr});
+            return pending;
+        }
+        void DestroyEntity(const entity entity) {
+            _commands.push_back(Command{CommandType::Destroy, 0, entity, nullptr, nullptr, nullptr});
+        }
+
+        template <typename TComponent>
+        void InsertComponent(const entity entity, TComponent component) {
+            void* payload = Allocate(sizeof(TComponent), alignof(TComponent));
+            new (payload) TComponent(std::move(component));
+            _commands.push_back(Command{CommandType::Insert, TypeIndexator<TComponent>::value(), entity, payload,
+                &ApplyInsert<World, TComponent>, &DestroyPayload<TComponent>});
+        }
+        template <typename TComponent>
+        void RemoveComponent(const entity entity) {
+            _commands.push_back(Command{CommandType::Remove, TypeIndexator<TComponent>::value(), entity, nullptr,
+                &ApplyRemove<World, TComponent>, nullptr});
+        }
+
+    public: // Data
+
+        [[nodiscard]] size_t size() const { return _commands.size(); }
+        [[nodiscard]] bool empty() const { return _commands.empty(); }
+
+        // destroys recorded components, keeps allocated memory
+        void clear() {
+            for (auto& command : _commands)
+                if (command.destroy) command.destroy(command.payload);
+            _commands.clear();
+            _created_count = 0;
+            _block = 0;
+            _block_offset = 0;
+        }
+
+    private:
+        enum class CommandType : uint8_t { Create, Insert, Remove, Destroy };
+
+        struct Command {
+            CommandType type;
+            type_index component_type;
+            ecs::entity entity;
+            void* payload;
+            void (*apply)(World& world, ecs::entity entity, void* payload);
+            void (*destroy)(void* payload);
+        };
+
+        struct Block {
+            std::unique_ptr<std::byte[]> data;
+            size_t size;
+        };
+        static constexpr size_t BLOCK_SIZE = 16 * 1024;
+
+        template <typename TWorld, typename TComponent>
+        static void ApplyInsert(TWorld& world, const entity entity, void* payload) {
+            world.InsertComponent(entity, std::move(*static_cast<TComponent*>(payload)));
+        }
+        template <typename TWorld, typename TComponent>
+        static void ApplyRemove(TWorld& world, const entity entity, void*) {
+            if (world.template ContainsComponent<TComponent>(entity))
+                world.template RemoveComponent<TComponent>(entity);
+        }
+        template <typename TComponent>
+        static void DestroyPayload(void* payload) {
+            static_cast<TComponent*>(payload)->~TComponent();
+        }
+
+        void* Allocate(const size_t size, const size_t alignment) {
+            while (_block < _blocks.size()) {
+                if (void* ptr = Place(_blocks[_block], size, alignment)) return ptr;
+                _block++;
+                _block_offset = 0;
+            }
+            // new block, big components get own block
+            const size_t block_size = std::max(BLOCK_SIZE, size + alignment);
+            _blocks.push_back(Block{std::make_unique<std::byte[]>(block_size), block_size});
+            return Place(_blocks.back(), size, alignment);
+        }
+        void* Place(Block& block, const size_t size, const size_t alignment) {
+            const auto begin = reinterpret_cast<std::uintptr_t>(block.data.get());
+            const auto address = (begin + _block_offset + alignment - 1) / alignment * alignment;
+            const size_t offset = static_cast<size_t>(address - begin);
+            if (offset + size > block.size) return nullptr;
+            _block_offset = offset + size;
+            return block.data.get() + offset;
+        }
+
+        std::vector<Command> _commands{};
+        std::vector<Block> _blocks{};
+        size_t _block = 0;
+        size_t _block_offset = 0;
+        entity_index _created_count = 0;
+
+        friend World;
+    };
+}
@@ -2,14 +2,84 @@
 
 #include "base.hpp"
 #include "types.hpp"
+#include "thread_pool.hpp"
+#include "memory_stats.hpp"
+#include "snapshot.hpp"
 
 #include <vector>
+#include <atomic>
 #include <type_traits>
 #include <cassert>
-#include <set>
+#include <algorithm>
+#include <limits>
+#include <numeric>
+#include <span>
+#include <bit>
+#include <new>
+#include <cstring>
+#include <memory_resource>
 
 namespace ecs {
 
+    // Sorting
+    // Pools are sorted by positions of packed arrays: less(index, index) compares entities at positions,
+    // swap(index, index) swaps them in pool (or in all pools of group).
+    // Full sorts permutation of positions and applies it along its cycles, so only misplaced entities are
+    // swapped, one swap per entity at most. Insertion swaps neighbours, it is linear for pools
+    // where only a few entities moved since the last sort
+
+    enum class SortAlgorithm { Full, Insertion };
+
+    template <typename Less, typename Swap>
+    void SortIndexes(const size_t begin, const size_t end, Less less, Swap swap, const SortAlgorithm algorithm = SortAlgorithm::Full) {
+        if (end <= begin + 1) return;
+        if (algorithm == SortAlgorithm::Insertion) {
+            for (size_t index = begin + 1; index < end; index++)
+                for (size_t position = index; position > begin && less(position, position - 1); position--)
+                    swap(position, position - 1);
+            return;
+        }
+
+        // order[i] is current position of entity, which goes to begin + i, stable sort keeps equal entities in place
+        std::vector<size_t> order(end - begin);
+        std::iota(order.begin(), order.end(), begin);
+        std::stable_sort(order.begin(), order.end(), less);
+        for (size_t index = begin; index < end; index++) {
+            size_t position = index;
+            while (order[position - begin] != index) {
+                const size_t next = order[position - begin];
+                swap(position, next);
+                order[position - begin] = position;
+                position = next;
+            }
+            order[position - begin] = position;
+        }
+    }
+
+    // Entities of other pool, which are in [begin, end) of pool, are moved to front of range in order of other pool,
+    // rest entities follow them. Every swap moves one entity to its final position
+    template <typename TPool, typename TOther, typename Swap>
+    void SortIndexesAs(const TPool& pool, const TOther& other, const size_t begin, const size_t end, Swap swap) {
+        size_t position = begin;
+        for (size_t other_index = 0; other_index < other.size() && position < end; other_index++) {
+            const entity entity = other.data()[other_index];
+            if (!pool.ContainsComponent(entity)) continue;
+            const size_t index = pool.GetIndex(entity);
+            if (index < position || index >= end) continue;
+            if (index != position) swap(position, index);
+            position++;
+        }
+    }
+
+    // less for SortIndexes from compare(entity, entity) or compare(component, component)
+    template <typename TPool, typename Compare>
+    [[nodiscard]] auto PoolLess(const TPool& pool, Compare& compare) {
+        return [&pool, &compare](const size_t a, const size_t b) -> bool {
+            if constexpr (std::is_invocable_v<Compare&, entity, entity>) return compare(pool.GetEntityAt(a), pool.GetEntityAt(b));
+            else return compare(pool.GetComponentAt(a), pool.GetComponentAt(b));
+        };
+    }
+
     // Interface Component Pool
     
     class IComponentPool {
@@ -24,36 +94,96 @@ namespace ecs {
         virtual void reset() = 0;
 
         virtual void RemoveComponent(const entity entity) = 0;
+        [[nodiscard]] virtual bool ContainsComponent(const entity entity) const = 0;
+        [[nodiscard]] virtual size_t size() const = 0;
+        // packed entities, which have component
+        [[nodiscard]] virtual const entity* data() const = 0;
+        [[nodiscard]] virtual PoolStats MemoryStats() const = 0;
+
+        // dense index access, valid in [0, size())
+        [[nodiscard]] virtual size_t GetIndex(const entity entity) const = 0;
+        virtual void SwapIndexes(const size_t index1, const size_t index2) = 0;
+
+        // Reorders pool as other, so views over both pools walk them forward together.
+        // Pool owned by group must be sorted with World::SortAs
+        void SortAs(const IComponentPool& other) {
+            SortIndexesAs(*this, other, 0, size(), [this](const size_t a, const size_t b) { SwapIndexes(a, b); });
+        }
+
+        // header and payload of pool, components are written only if trivially copyable
+        [[nodiscard]] virtual SnapshotPoolHeader GetSnapshotHeader() const = 0;
+        virtual void SaveSnapshot(SnapshotWriter& writer) const = 0;
+        [[nodiscard]] virtual bool CanLoadSnapshot(const SnapshotPoolHeader& header) const = 0;
+        // payload of count components, which starts with their entities, 0 if components aren't written
+        [[nodiscard]] virtual size_t GetSnapshotPayloadBytes(size_t count) const = 0;
+        // replaces components with payload, which starts at reader position and is validated by World
+        virtual void LoadSnapshot(const SnapshotPoolHeader& header, SnapshotReader& reader) = 0;
+
+        // packed bytes of components for deltas, only trivially copyable components have them.
+        // Packed bytes are members one after another for SoA pools, so they can be smaller than component
+        [[nodiscard]] virtual bool IsTriviallyCopyable() const = 0;
+        [[nodiscard]] virtual size_t GetPackedSize() const = 0;
+        [[nodiscard]] virtual std::span<const tick> GetChangedTicks() const = 0;
+        virtual void ReadPacked(size_t index, std::byte* out) const = 0;
+        // component at index of snapshot payload, which was written by pool of this type with count components
+        virtual void ReadSnapshotPacked(const std::byte* payload, size_t count, size_t index, std::byte* out) const = 0;
+        // inserts component from mask (XOR with zeros) or XORs existing component with mask, stamps changed tick
+        virtual void ApplyPacked(const entity entity, const std::byte* mask, bool patch) = 0;
+
+        // tick stamped to added/changed components, never decreases
+        void SetTick(const tick tick) {
+            ecs::tick current = _tick.load(std::memory_order_relaxed);
+            while (current < tick && !_tick.compare_exchange_weak(current, tick, std::memory_order_relaxed)) {}
+        }
+        [[nodiscard]] tick GetTick() const { return _tick.load(std::memory_order_relaxed); }
+
+    protected:
+        std::atomic<tick> _tick{0};
     };
 
     // Component Pool
+    // Sparse set: _sparse maps entity index to index in packed _dense (entities) and components arrays,
+    // so insert/remove are O(1) (swap-and-pop) and active components are always contiguous.
+    // Components are stored in pages of PAGE_BYTES from memory resource, so growth never relocates
+    // components (removal still moves last component into the hole) and empty pages are released.
+    // Added/changed ticks are kept per packed component, mutable access stamps changed tick
 
     template<typename TComponent>
-    class ComponentPool : public IComponentPool {
+    class ComponentPool final : public IComponentPool {
         static_assert(std::is_move_constructible_v<TComponent>, "Cannot create pool for component which is not move constructible");
 	    static_assert(std::is_destructible_v<TComponent>, "Cannot create pool for component which is not destructible");
         static_assert(std::is_default_constructible_v<TComponent>, "Cannot create pool for component which doesn't has default constructor");
-    
+
     public:
+        static constexpr size_t PAGE_BYTES = 16 * 1024;
+        // components per page, power of two for cheap index split
+        static constexpr size_t PAGE_SIZE = std::bit_floor(std::max<size_t>(1, PAGE_BYTES / sizeof(TComponent)));
+        static constexpr size_t PAGE_SHIFT = std::countr_zero(PAGE_SIZE);
+        static constexpr size_t PAGE_MASK = PAGE_SIZE - 1;
+        static constexpr size_t PAGE_ALIGNMENT = std::max(alignof(TComponent), CACHE_LINE_SIZE);
+        // chunks of parallel iteration start on cache line of components and of changed ticks, which they stamp
+        static constexpr size_t PARALLEL_ALIGNMENT = std::lcm(CACHE_LINE_SIZE / std::gcd(sizeof(TComponent), CACHE_LINE_SIZE),
+            CACHE_LINE_SIZE / std::gcd(sizeof(tick), CACHE_LINE_SIZE));
+
+        using reference = TComponent&;
+        using const_reference = const TComponent&;
+
         class iterator {
         public:
             using iterator_category = std::forward_iterator_tag;
             using difference_type = std::ptrdiff_t;
+            using value_type = TComponent;
+            using pointer = TComponent*;
+            using reference = TComponent&;
 
-            iterator(std::set<entity>::iterator setIter, std::vector<TComponent>& vec)
-                : _setIter(setIter), _vec{vec} {}
+            iterator(TComponent* const* pages, size_t index)
+                : _pages(pages), _index{index} {}
             
-            TComponent& operator*() {
-                auto& entity = *_setIter;
-                return _vec.at(entity);
-            }
-            TComponent* operator->() {
-                auto entity = *_setIter;
-                return *_vec[entity];
-            }
+            TComponent& operator*() const { return _pages[_index >> PAGE_SHIFT][_index & PAGE_MASK]; }
+            TComponent* operator->() const { return &**this; }
 
             iterator& operator++() { // Prefix increment
-                ++_setIter;
+                ++_index;
                 return *this;
             }
             iterator operator++(int) { // Postfix increment
@@ -63,89 +193,380 @@ namespace ecs {
             }
 
             [[nodiscard]] friend bool operator== (const iterator& a, const iterator& b)
-                { return a._setIter == b._setIter; };
+                { return a._index == b._index; };
             [[nodiscard]] friend bool operator!= (const iterator& a, const iterator& b)
-                { return a._setIter != b._setIter; };
+                { return a._index != b._index; };
 
         private:
-            std::set<entity>::iterator _setIter;
-            std::vector<TComponent>& _vec;
+            TComponent* const* _pages;
+            size_t _index;
         };
-
+    
     public: // Core
 
         // Constructors
-        ComponentPool() = default;
-        ~ComponentPool() = default;
+        ComponentPool(uint32_t reserve_entities = DEFAULT_ENTITIES_CAPACITY, 
+            std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+            : _resource{resource}, _sparse{resource}, _dense{resource}, _added{resource}, _changed{resource}, _pages{resource} {
+            resize(reserve_entities);
+        }
+        ~ComponentPool() {
+            clear();
+            ReleasePages(0);
+        }
         // Move
-	    ComponentPool(ComponentPool&&)				 = default;
-	    ComponentPool& operator=(ComponentPool&&)		 = default;
+	    ComponentPool(ComponentPool&& other) noexcept
+            : _resource{other._resource}, _sparse{std::move(other._sparse)}, 
+            _dense{std::move(other._dense)}, _added{std::move(other._added)}, _changed{std::move(other._changed)},
+            _pages{std::move(other._pages)} {
+            SetTick(other.GetTick());
+            other._dense.clear();
+            other._pages.clear();
+        }
         // Copy
-	    ComponentPool(const ComponentPool&)			 = default;
-	    ComponentPool& operator=(const ComponentPool&) = default;
-
-        ComponentPool(uint32_t reserve_entities = DEFAULT_ENTITIES_CAPACITY) {
-            resize(reserve_entities);
+	    ComponentPool(const ComponentPool& other)
+            : _resource{other._resource}, _sparse{other._sparse, other._resource}, 
+            _dense{other._resource}, _added{other._added, other._resource}, _changed{other._changed, other._resource},
+            _pages{other._resource} {
+            SetTick(other.GetTick());
+            reserve(other.size());
+            for (size_t index = 0; index < other.size(); index++) {
+                new (Slot(index)) TComponent(*other.Slot(index));
+                _dense.push_back(other._dense[index]);
+            }
         }
+        // Pool is bound to its memory resource, as pmr containers
+	    ComponentPool& operator=(ComponentPool&&)		 = delete;
+	    ComponentPool& operator=(const ComponentPool&) = delete;
 
+        // reserve memory for active components
         void reserve(size_t new_capacity) override {
-            _components.reserve(new_capacity);
+            _dense.reserve(new_capacity);
+            _added.reserve(new_capacity);
+            _changed.reserve(new_capacity);
+            while (capacity() < new_capacity) AllocatePage();
         }
+        // set range of entities, which can be stored in pool
         void resize(size_t new_size) override {
-            _components.resize(new_size);
+            assert((new_size >= _sparse.size() || std::all_of(_sparse.begin() + new_size, _sparse.end(),
+                [](const uint32_t index) { return index == NULL_INDEX; })) && "Can't erase entities with components");
+            _sparse.resize(new_size, NULL_INDEX);
         }
         void shrink_to_fit() override {
-            _components.shrink_to_fit();
+            _dense.shrink_to_fit();
+            _added.shrink_to_fit();
+            _changed.shrink_to_fit();
+            ReleasePages(0);
         }
 
         void clear() override {
-            _components.clear();
-            _entities.clear();
+            std::fill(_sparse.begin(), _sparse.end(), NULL_INDEX);
+            for (size_t index = 0; index < _dense.size(); index++)
+                Slot(index)->~TComponent();
+            _dense.clear();
+            _added.clear();
+            _changed.clear();
         }
         void reset() override {
             clear();
             shrink_to_fit();
         }
         
-        void InsertComponent(const entity entity, TComponent& component) {
-            assert(entity < _components.size() && "Entity out of range");
-            _components[entity] = component;
-            _entities.insert(entity);
+        void InsertComponent(const entity entity, TComponent component) {
+            assert(GetEntityIndex(entity) < _sparse.size() && "Entity out of range");
+            uint32_t& index = _sparse[GetEntityIndex(entity)];
+            if (index != NULL_INDEX) {
+                assert(_dense[index] == entity && "Component belongs to other version of entity");
+                *Slot(index) = std::move(component);
+                _changed[index] = GetTick();
+                return;
+            }
+            if (_dense.size() == capacity()) AllocatePage();
+            index = static_cast<uint32_t>(_dense.size());
+            new (Slot(index)) TComponent(std::move(component));
+            _dense.push_back(entity);
+            _added.push_back(GetTick());
+            _changed.push_back(GetTick());
+        }
+        void InsertComponents(std::span<const entity> entities, std::span<const TComponent> components) {
+            assert(entities.size() == components.size() && "Count of entities and components must be equal");
+            Grow(entities.size());
+            for (size_t i = 0; i < entities.size(); i++)
+                InsertComponent(entities[i], components[i]);
+        }
+        void InsertComponents(std::span<const entity> entities, const TComponent& component) {
+            Grow(entities.size());
+            for (auto entity : entities)
+                InsertComponent(entity, component);
         }
         void RemoveComponent(const entity entity) override {
-            assert(entity < _components.size() && "Entity out of range");
-            assert(_entities.contains(entity) && "Entity doesn't have that component");
-            _entities.erase(entity);
+            assert(ContainsComponent(entity) && "Entity doesn't have that component");
+
+            uint32_t index = _sparse[GetEntityIndex(entity)];
+            uint32_t last = static_cast<uint32_t>(_dense.size() - 1);
+            if (index != last) { // move last into the hole
+                ecs::entity moved = _dense[last];
+                _dense[index] = moved;
+                *Slot(index) = std::move(*Slot(last));
+                _added[index] = _added[last];
+                _changed[index] = _changed[last];
+                _sparse[GetEntityIndex(moved)] = index;
+            }
+            Slot(last)->~TComponent();
+            _dense.pop_back();
+            _added.pop_back();
+            _changed.pop_back();
+            _sparse[GetEntityIndex(entity)] = NULL_INDEX;
+
+            // keep one spare page, so insert/remove on page border doesn't allocate each time
+            if ((last & PAGE_MASK) == 0) ReleasePages(1);
+        }
+        [[nodiscard]] bool ContainsComponent(const entity entity) const override {
+            const entity_index index = GetEntityIndex(entity);
+            return index < _sparse.size() && _sparse[index] != NULL_INDEX && _dense[_sparse[index]] == entity;
         }
+        // mutable access, stamps changed tick
         TComponent& GetComponent(const entity entity) {
-            assert(entity < _components.size() && "Entity out of range");
-            return _components[entity];
+            assert(ContainsComponent(entity) && "Entity doesn't have that component");
+            const uint32_t index = _sparse[GetEntityIndex(entity)];
+            _changed[index] = GetTick();
+            return *Slot(index);
         }
         
-        [[nodiscard]] TComponent& operator[](const entity entity) const {
-            assert(entity < _components.size() && "Entity out of range");
-            return _components[entity];
+        // read only access, doesn't stamp changed tick
+        [[nodiscard]] const TComponent& operator[](const entity entity) const {
+            assert(ContainsComponent(entity) && "Entity doesn't have that component");
+            return *Slot(_sparse[GetEntityIndex(entity)]);
         }
 
-    public: // Iterators
+        // component was added/changed after since tick
+        [[nodiscard]] bool IsAdded(const entity entity, const tick since) const {
+            assert(ContainsComponent(entity) && "Entity doesn't have that component");
+            return _added[_sparse[GetEntityIndex(entity)]] > since;
+        }
+        [[nodiscard]] bool IsChanged(const entity entity, const tick since) const {
+            assert(ContainsComponent(entity) && "Entity doesn't have that component");
+            return _changed[_sparse[GetEntityIndex(entity)]] > since;
+        }
+        // for writes, which bypass GetComponent (iterators, pointers kept by user)
+        void MarkChanged(const entity entity) {
+            assert(ContainsComponent(entity) && "Entity doesn't have that component");
+            _changed[_sparse[GetEntityIndex(entity)]] = GetTick();
+        }
+
+        // dense index access, valid in [0, size())
+        [[nodiscard]] size_t GetIndex(const entity entity) const override {
+            assert(ContainsComponent(entity) && "Entity doesn't have that component");
+            return _sparse[GetEntityIndex(entity)];
+        }
+        [[nodiscard]] entity GetEntityAt(const size_t index) const {
+            assert(index < _dense.size() && "Index out of range");
+            return _dense[index];
+        }
+        [[nodiscard]] TComponent& GetComponentAt(const size_t index) {
+            assert(index < _dense.size() && "Index out of range");
+            _changed[index] = GetTick();
+            return *Slot(index);
+        }
+        [[nodiscard]] const TComponent& GetComponentAt(const size_t index) const {
+            assert(index < _dense.size() && "Index out of range");
+            return *Slot(index);
+        }
+        [[nodiscard]] tick GetAddedTickAt(const size_t index) const { return _added[index]; }
+        [[nodiscard]] tick GetChangedTickAt(const size_t index) const { return _changed[index]; }
+        void SwapIndexes(const size_t index1, const size_t index2) override {
+            assert(index1 < _dense.size() && index2 < _dense.size() && "Index out of range");
+            if (index1 == index2) return;
+            std::swap(_dense[index1], _dense[index2]);
+            std::swap(*Slot(index1), *Slot(index2));
+            std::swap(_added[index1], _added[index2]);
+            std::swap(_changed[index1], _changed[index2]);
+            _sparse[GetEntityIndex(_dense[index1])] = static_cast<uint32_t>(index1);
+            _sparse[GetEntityIndex(_dense[index2])] = static_cast<uint32_t>(index2);
+        }
+
+        // compare(const TComponent&, const TComponent&) or compare(entity, entity), for spatial or material locality.
+        // Pool owned by group must be sorted with World::Sort
+        template <typename Compare>
+        void Sort(Compare compare, const SortAlgorithm algorithm = SortAlgorithm::Full) {
+            SortIndexes(0, size(), PoolLess(*this, compare), [this](const size_t a, const size_t b) { SwapIndexes(a, b); }, algorithm);
+        }
+
+        // func(TComponent&) or func(entity, TComponent&) for every component, chunks are split on cache lines.
+        // Stamps changed tick of every component
+        template <typename Func>
+        void ParallelForEach(Func func, const size_t grain = DEFAULT_PARALLEL_GRAIN, 
+            ThreadPool& thread_pool = ThreadPool::Shared()) {
+            auto chunk = [this, &func](const size_t begin, const size_t end) { ForRange(begin, end, func); };
+            thread_pool.ParallelChunks(_dense.size(), grain, PARALLEL_ALIGNMENT, chunk);
+        }
+
+        [[nodiscard]] size_t size() const override { return _dense.size(); }
+        [[nodiscard]] const entity* data() const override { return _dense.data(); }
+        [[nodiscard]] size_t capacity() const { return _pages.size() * PAGE_SIZE; }
+        [[nodiscard]] PoolStats MemoryStats() const override {
+            PoolStats stats{};
+            stats.count = _dense.size();
+            stats.capacity = capacity();
+            stats.sparse_bytes = _sparse.capacity() * sizeof(uint32_t);
+            stats.used_bytes = _sparse.size() * sizeof(uint32_t)
+                + _dense.size() * (sizeof(entity) + 2 * sizeof(tick) + sizeof(TComponent));
+            stats.reserved_bytes = stats.sparse_bytes + (_dense.capacity() * sizeof(entity))
+                + (_added.capacity() + _changed.capacity()) * sizeof(tick)
+                + _pages.capacity() * sizeof(TComponent*) + _pages.size() * PAGE_SIZE * sizeof(TComponent);
+            return stats;
+        }
+        [[nodiscard]] std::pmr::memory_resource* GetResource() const { return _resource; }
 
-        [[nodiscard]] std::vector<TComponent>::iterator begin_comp_all() { return _components.begin(); }
-        [[nodiscard]] std::vector<TComponent>::iterator end_comp_all() { return _components.end(); }
+    public: // Snapshot
 
-        // e = entity, iterate components only for entities
-        [[nodiscard]] iterator begin_comp_active() {
-            auto entities = _entities.begin();
-            auto& components = _components;
-            return iterator{entities, components};
+        [[nodiscard]] SnapshotPoolHeader GetSnapshotHeader() const override {
+            return SnapshotPoolHeader{SnapshotTypeHash<TComponent>(), 0, sizeof(TComponent), static_cast<uint32_t>(_dense.size()),
+                std::is_trivially_copyable_v<TComponent> ? SnapshotPoolHeader::RAW : 0, 0};
+        }
+        void SaveSnapshot(SnapshotWriter& writer) const override {
+            const size_t count = _dense.size();
+            SnapshotPoolHeader header = GetSnapshotHeader();
+            header.payload_bytes = GetSnapshotPayloadBytes(count);
+            writer.Write(header);
+            writer.Align();
+            if constexpr (std::is_trivially_copyable_v<TComponent>) {
+                writer.Block(_dense.data(), count * sizeof(entity));
+                writer.Block(_added.data(), count * sizeof(tick));
+                writer.Block(_changed.data(), count * sizeof(tick));
+                for (size_t begin = 0; begin < count; begin += PAGE_SIZE)
+                    writer.Write(_pages[begin >> PAGE_SHIFT], std::min(PAGE_SIZE, count - begin) * sizeof(TComponent));
+                writer.Align();
+            }
+        }
+        [[nodiscard]] bool CanLoadSnapshot(const SnapshotPoolHeader& header) const override {
+            return header.type_hash == SnapshotTypeHash<TComponent>() && header.component_size == sizeof(TComponent)
+                && ((header.flags & SnapshotPoolHeader::RAW) != 0) == std::is_trivially_copyable_v<TComponent>;
         }
-        [[nodiscard]] iterator end_comp_active() {
-            auto entities = _entities.end();
-            auto& components = _components;
-            return iterator{entities, components};
+        [[nodiscard]] size_t GetSnapshotPayloadBytes(const size_t count) const override {
+            if constexpr (!std::is_trivially_copyable_v<TComponent>) return 0;
+            return SnapshotAligned(count * sizeof(entity)) + 2 * SnapshotAligned(count * sizeof(tick))
+                + SnapshotAligned(count * sizeof(TComponent));
         }
+        // one bulk copy per array, components are copied page by page
+        void LoadSnapshot(const SnapshotPoolHeader& header, SnapshotReader& reader) override {
+            clear();
+            if constexpr (std::is_trivially_copyable_v<TComponent>) {
+                if (!(header.flags & SnapshotPoolHeader::RAW)) return;
+                const size_t count = header.count;
+                const std::byte* entities = reader.Block(count * sizeof(entity));
+                const std::byte* added = reader.Block(count * sizeof(tick));
+                const std::byte* changed = reader.Block(count * sizeof(tick));
+                const std::byte* components = reader.Block(count * sizeof(TComponent));
+                assert(entities && added && changed && components && "Snapshot payload is out of range");
+
+                reserve(count);
+                _dense.resize(count);
+                _added.resize(count);
+                _changed.resize(count);
+                if (count == 0) return;
+                std::memcpy(_dense.data(), entities, count * sizeof(entity));
+                std::memcpy(_added.data(), added, count * sizeof(tick));
+                std::memcpy(_changed.data(), changed, count * sizeof(tick));
+                for (size_t begin = 0; begin < count; begin += PAGE_SIZE)
+                    std::memcpy(_pages[begin >> PAGE_SHIFT], components + begin * sizeof(TComponent),
+                        std::min(PAGE_SIZE, count - begin) * sizeof(TComponent));
+                for (size_t index = 0; index < count; index++) {
+                    assert(GetEntityIndex(_dense[index]) < _sparse.size() && "Entity out of range");
+                    _sparse[GetEntityIndex(_dense[index])] = static_cast<uint32_t>(index);
+                }
+            }
+        }
+
+    public: // Deltas
+
+        [[nodiscard]] bool IsTriviallyCopyable() const override { return std::is_trivially_copyable_v<TComponent>; }
+        [[nodiscard]] size_t GetPackedSize() const override { return sizeof(TComponent); }
+        [[nodiscard]] std::span<const tick> GetChangedTicks() const override { return _changed; }
+        void ReadPacked(const size_t index, std::byte* out) const override {
+            assert(index < _dense.size() && "Index out of range");
+            if constexpr (std::is_trivially_copyable_v<TComponent>) std::memcpy(out, Slot(index), sizeof(TComponent));
+            else assert(false && "Component isn't trivially copyable");
+        }
+        void ReadSnapshotPacked(const std::byte* payload, const size_t count, const size_t index, std::byte* out) const override {
+            const size_t components = SnapshotAligned(count * sizeof(entity)) + 2 * SnapshotAligned(count * sizeof(tick));
+            std::memcpy(out, payload + components + index * sizeof(TComponent), sizeof(TComponent));
+        }
+        void ApplyPacked(const entity entity, const std::byte* mask, const bool patch) override {
+            if constexpr (std::is_trivially_copyable_v<TComponent>) {
+                if (!patch) {
+                    TComponent component;
+                    std::memcpy(static_cast<void*>(&component), mask, sizeof(TComponent));
+                    InsertComponent(entity, component);
+                    return;
+                }
+                std::byte* bytes = reinterpret_cast<std::byte*>(&GetComponent(entity));
+                for (size_t i = 0; i < sizeof(TComponent); i++) bytes[i] ^= mask[i];
+            }
+            else assert(false && "Component isn't trivially copyable");
+        }
+
+    public: // Iterators
+
+        // iterate packed components, order is the same as in begin_ent_active.
+        // Raw access, writes through iterator must be reported with MarkChanged
+        [[nodiscard]] iterator begin_comp_active() { return iterator{_pages.data(), 0}; }
+        [[nodiscard]] iterator end_comp_active() { return iterator{_pages.data(), _dense.size()}; }
+
+        // iterate packed entities, which have component
+        [[nodiscard]] auto begin_ent_active() const { return _dense.cbegin(); }
+        [[nodiscard]] auto end_ent_active() const { return _dense.cend(); }
         
     private:
-        std::vector<TComponent> _components{};
-        std::set<entity> _entities{};
+        [[nodiscard]] TComponent* Slot(const size_t index) const {
+            return _pages[index >> PAGE_SHIFT] + (index & PAGE_MASK);
+        }
+
+        // func for [begin, end), inner loop is a plain array walk inside one page
+        template <typename Func>
+        void ForRange(size_t begin, const size_t end, Func& func) {
+            while (begin < end) {
+                TComponent* page = _pages[begin >> PAGE_SHIFT];
+                const size_t offset = begin & PAGE_MASK;
+                const size_t count = std::min(PAGE_SIZE - offset, end - begin);
+                std::fill_n(_changed.begin() + begin, count, GetTick());
+                for (size_t i = 0; i < count; i++) {
+                    if constexpr (std::is_invocable_v<Func, entity, TComponent&>)
+                        func(_dense[begin + i], page[offset + i]);
+                    else
+                        func(page[offset + i]);
+                }
+                begin += count;
+            }
+        }
+
+        void AllocatePage() {
+            void* page = _resource->allocate(PAGE_SIZE * sizeof(TComponent), PAGE_ALIGNMENT);
+            _pages.push_back(static_cast<TComponent*>(page));
+        }
+        // releases pages after used, except spare
+        void ReleasePages(const size_t spare) {
+            const size_t used = (_dense.size() + PAGE_MASK) >> PAGE_SHIFT;
+            while (_pages.size() > used + spare) {
+                _resource->deallocate(_pages.back(), PAGE_SIZE * sizeof(TComponent), PAGE_ALIGNMENT);
+                _pages.pop_back();
+            }
+        }
+
+        // reserve for count more components, keeps geometric growth for repeated batches
+        void Grow(const size_t count) {
+            const size_t required = _dense.size() + count;
+            if (required > _dense.capacity())
+                reserve(std::max(required, _dense.capacity() * 2));
+        }
+
+        static constexpr uint32_t NULL_INDEX = std::numeric_limits<uint32_t>::max();
+
+        std::pmr::memory_resource* _resource;
+        std::pmr::vector<uint32_t> _sparse;
+        std::pmr::vector<entity> _dense;
+        std::pmr::vector<tick> _added; // tick of insert, packed as _dense
+        std::pmr::vector<tick> _changed; // tick of last mutable access, packed as _dense
+        std::pmr::vector<TComponent*> _pages; // pages of PAGE_SIZE components
     };
 }
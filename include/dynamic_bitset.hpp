@@ -1,4 +1,4 @@
-// Dynamic bitset (required C++14)
+// Dynamic bitset (required C++20)
 // Modified version of:
 // https://github.com/syoyo/dynamic_bitset/blob/master/dynamic_bitset.hh
 // https://github.com/martinstarkov/ecs/blob/main/include/ecs/ecs.h
@@ -8,26 +8,37 @@
 
 #include <vector>
 #include <cassert>
+#include <cstdint>
+#include <bit>
+#include <algorithm>
 
 namespace ecs
 {
+    // Bits are stored in uint64_t words, bit i is (word[i / 64] >> (i % 64)) & 1.
+    // Bits after size() in the last word are always 0, so bulk operations
+    // work on whole words without masking and loops can be vectorized by compiler
     class dynamic_bitset {
+    public:
+        using word_type = std::uint64_t;
+        static constexpr size_t WORD_BITS = 64;
+        static constexpr size_t npos = static_cast<size_t>(-1);
+
+    private:
         class const_iterator {
         public:
             using iterator_category = std::forward_iterator_tag;
             using difference_type = std::ptrdiff_t;
 
-            constexpr const_iterator(uint8_t* ptr, const uint8_t& offset)
+            constexpr const_iterator(const word_type* ptr, const uint8_t& offset)
                 : _ptr(ptr), _offset{offset} {}
 
             bool operator*() const
             {
-    	        uint8_t answer = (*_ptr << _offset) & BIT_LEFT;
-    	        return answer;
+                return (*_ptr >> _offset) & BIT_RIGHT;
             }
 
             const_iterator& operator++() { // Prefix increment
-                if (_offset >= 7) {
+                if (_offset >= WORD_BITS - 1) {
                     ++_ptr;
                     _offset = 0;
                 }
@@ -48,7 +59,7 @@ namespace ecs
                 { return a._ptr != b._ptr || a._offset != b._offset; };
 
         private:
-            uint8_t* _ptr;
+            const word_type* _ptr;
             uint8_t _offset;
         };
 
@@ -56,9 +67,9 @@ namespace ecs
         dynamic_bitset() = default;
         ~dynamic_bitset() = default;
 
-        dynamic_bitset(const size_t& new_size, const bool& value = false) 
+        dynamic_bitset(const size_t& new_size, const bool& value = false)
             { resize(new_size, value); }
-        dynamic_bitset(const size_t& new_size, const size_t& new_capacity, const bool& value = false) 
+        dynamic_bitset(const size_t& new_size, const size_t& new_capacity, const bool& value = false)
             { reserve(new_capacity); resize(new_size, value); }
 
         dynamic_bitset(dynamic_bitset&&) = default;
@@ -69,139 +80,187 @@ namespace ecs
 
     public:
         void set(const size_t& bit_index, const bool& value = true) {
-            size_t byte_index = bit_index / 8;
-    	    uint8_t offset = static_cast<uint8_t>(bit_index % 8);
-    	    uint8_t bitfield = static_cast<uint8_t>(BIT_LEFT >> offset);
-
     	    assert(bit_index < _bit_size && "Bit index out of range");
-    	    assert(byte_index < _data.size() && "Byte index out of range");
 
-    	    if (value) // merge source and answer bytes with OR
-    	    	_data[byte_index] |= bitfield;
-    	    else // merge source and inverse answer bytes with AND
-                _data[byte_index] &= (~bitfield);
+            word_type bitfield = BIT_RIGHT << (bit_index % WORD_BITS);
+    	    if (value) // merge source and answer words with OR
+    	    	_data[bit_index / WORD_BITS] |= bitfield;
+    	    else // merge source and inverse answer words with AND
+                _data[bit_index / WORD_BITS] &= ~bitfield;
         }
-        [[nodiscard]] bool get(const size_t& bit_index) {
-            size_t byte_index = bit_index / 8;
-    	    size_t offset = bit_index % 8;
-
+        [[nodiscard]] bool get(const size_t& bit_index) const {
     	    assert(bit_index < _bit_size && "Bit index out of range");
-    	    assert(byte_index < _data.size() && "Byte index out of range");
-
-    	    uint8_t answer = (_data[byte_index] << offset) & BIT_LEFT;
-    	    return answer;
+            return (_data[bit_index / WORD_BITS] >> (bit_index % WORD_BITS)) & BIT_RIGHT;
         }
 
         [[nodiscard]] bool operator[](const std::size_t& bit_index) const {
-            size_t byte_index = bit_index / 8;
-    	    size_t offset = bit_index % 8;
+            return get(bit_index);
+        }
 
-    	    assert(bit_index < _bit_size && "Bit index out of range");
-    	    assert(byte_index < _data.size() && "Byte index out of range");
+        [[nodiscard]] bool operator==(const dynamic_bitset& other) const
+            { return _bit_size == other._bit_size && _data == other._data; }
 
-    	    uint8_t answer = (_data[byte_index] << offset) & BIT_LEFT;
-    	    return answer; // take first bit
+    public: // Bulk operations, work with bitsets of different sizes as if missing bits are 0
 
-            // also you can remove all bits except bit field and compare as byte
-            // return (data[byte_index] & bitfield) == bitfield;
+        dynamic_bitset& operator&=(const dynamic_bitset& other) {
+            const size_t common = std::min(_data.size(), other._data.size());
+            for (size_t i = 0; i < common; i++)
+                _data[i] &= other._data[i];
+            for (size_t i = common; i < _data.size(); i++)
+                _data[i] = ALL0;
+            return *this;
+        }
+        dynamic_bitset& operator|=(const dynamic_bitset& other) {
+            const size_t common = std::min(_data.size(), other._data.size());
+            for (size_t i = 0; i < common; i++)
+                _data[i] |= other._data[i];
+            ClearUnusedBits(); // bits of other after size() are dropped
+            return *this;
+        }
+        // and not, removes all bits of other
+        dynamic_bitset& operator-=(const dynamic_bitset& other) {
+            const size_t common = std::min(_data.size(), other._data.size());
+            for (size_t i = 0; i < common; i++)
+                _data[i] &= ~other._data[i];
+            return *this;
         }
 
-        [[nodiscard]] bool operator==(const dynamic_bitset& other) const
-            { return _bit_size == other._bit_size && _data == other._data; }
+        // has any common set bit with other
+        [[nodiscard]] bool intersects(const dynamic_bitset& other) const {
+            const size_t common = std::min(_data.size(), other._data.size());
+            for (size_t i = 0; i < common; i++)
+                if (_data[i] & other._data[i]) return true;
+            return false;
+        }
+        // all set bits of this are set in other
+        [[nodiscard]] bool is_subset_of(const dynamic_bitset& other) const {
+            const size_t common = std::min(_data.size(), other._data.size());
+            word_type rest = ALL0;
+            for (size_t i = 0; i < common; i++)
+                rest |= _data[i] & ~other._data[i];
+            for (size_t i = common; i < _data.size(); i++)
+                rest |= _data[i];
+            return rest == ALL0;
+        }
+
+        // count of set bits
+        [[nodiscard]] size_t count() const {
+            size_t result = 0;
+            for (size_t i = 0; i < _data.size(); i++)
+                result += static_cast<size_t>(std::popcount(_data[i]));
+            return result;
+        }
+
+        // index of first set bit or npos
+        [[nodiscard]] size_t find_first() const {
+            return find_from(0);
+        }
+        // index of first set bit after bit_index or npos
+        [[nodiscard]] size_t find_next(const size_t& bit_index) const {
+            if (bit_index + 1 >= _bit_size) return npos;
+            return find_from(bit_index + 1);
+        }
+
+        [[nodiscard]] bool any() const {
+            for (size_t i = 0; i < _data.size(); i++)
+                if (_data[i] != ALL0) return true;
+            return false;
+        }
+        [[nodiscard]] bool none() const { return !any(); }
+        [[nodiscard]] bool all() const { return count() == _bit_size; }
 
     public:
         [[nodiscard]] size_t size() const { return _bit_size; }
-        [[nodiscard]] size_t capacity() const { return _data.capacity(); }
-        [[nodiscard]] std::vector<uint8_t> data() const { return _data; }
+        [[nodiscard]] size_t capacity() const { return _data.capacity() * WORD_BITS; }
+        [[nodiscard]] const std::vector<word_type>& data() const { return _data; }
 
         void reserve(const size_t& new_capacity) {
-            size_t byte_count = GetByteCount(new_capacity);
-            _data.reserve(byte_count);
+            _data.reserve(GetWordCount(new_capacity));
         }
 
         void resize(const size_t& new_size, const bool& value = false) {
-            if (new_size > _bit_size && _bit_size > 0) { // update allocated bits
-                auto& last = _data.back();
-                if (value) {
-                    uint8_t offset = static_cast<uint8_t>(8 - _bit_size % 8);
-                    uint8_t bits_last = ALL1 >> offset;
-                    last |= bits_last;
-                } else {
-                    uint8_t offset = static_cast<uint8_t>(_bit_size % 8);
-                    uint8_t bits_last = ALL1 << offset;
-                    last &= bits_last;
-                }
-            }
-
-            size_t byte_count = GetByteCount(new_size);
-            _data.resize(byte_count, value ? ALL1 : ALL0);
+            const size_t old_size = _bit_size;
+            _data.resize(GetWordCount(new_size), ALL0);
             _bit_size = new_size;
+
+            if (value && new_size > old_size) { // fill new bits in old last word too
+                for (size_t i = old_size; i < new_size && i % WORD_BITS != 0; i++)
+                    set(i, true);
+                for (size_t i = GetWordCount(old_size); i < _data.size(); i++)
+                    _data[i] = ALL1;
+            }
+            ClearUnusedBits();
         }
 
         void reset(const bool& value = false) {
-            if (_bit_size == 0) return;
-
-            uint8_t byte_content = value ? ALL1 : ALL0;
-            for (size_t i = 0; i < _data.size(); i++)
-                _data[i] = byte_content;
-            // all bits, which allocated and not in size() updated too
+            std::fill(_data.begin(), _data.end(), value ? ALL1 : ALL0);
+            ClearUnusedBits();
         }
 
         void clear() { _bit_size = 0; _data.clear(); }
         void shrink_to_fit() { _data.shrink_to_fit(); }
 
     public:
-        [[nodiscard]] const_iterator begin() { // TODO make const
-            assert(_data.size() > 0 && "Can't iterate empty data");
+        [[nodiscard]] const_iterator begin() const {
             return const_iterator(_data.data(), 0);
         }
-        [[nodiscard]] const_iterator end() {
-            assert(_data.size() > 0 && "Can't iterate empty data");
-    	    uint8_t offset = _bit_size % 8;
-            return const_iterator(&_data.back(), offset);
+        [[nodiscard]] const_iterator end() const {
+    	    uint8_t offset = static_cast<uint8_t>(_bit_size % WORD_BITS);
+            return const_iterator(_data.data() + _bit_size / WORD_BITS, offset);
         }
 
-        // @TODO can be much more efficient if iterate through bytes of data, not bits
-        
-        [[nodiscard]] bool any(const size_t& start_range, const size_t& end_range, const bool& any_value = true) {
+        // is there any bit == any_value in [start_range, end_range)
+        [[nodiscard]] bool any(const size_t& start_range, const size_t& end_range, const bool& any_value = true) const {
     	    assert(start_range <= end_range && "end_range can't be larger than start_range");
-    	    assert(end_range < _bit_size && "end_range out of range");
-
-            for (size_t i = start_range; i < end_range; i++) {
-                if (get(i) == any_value) {
-                    return true;
-                }
+    	    assert(end_range <= _bit_size && "end_range out of range");
+
+            for (size_t i = start_range; i < end_range; ) {
+                const size_t word_index = i / WORD_BITS;
+                const size_t offset = i % WORD_BITS;
+                const size_t count = std::min(WORD_BITS - offset, end_range - i);
+                const word_type mask = RangeMask(offset, count);
+                const word_type word = any_value ? _data[word_index] : ~_data[word_index];
+                if (word & mask) return true;
+                i += count;
             }
             return false;
         }
-        [[nodiscard]] bool all(const size_t& start_range, const size_t& end_range, const bool& all_value = true) {
-    	    assert(start_range <= end_range && "end_range can't be larger than start_range");
-    	    assert(end_range < _bit_size && "end_range out of range");
-
-            for (size_t i = start_range; i < end_range; i++) {
-                if (get(i) != all_value) {
-                    return false;
-                }
-            }
-            return true;
+        // are all bits == all_value in [start_range, end_range)
+        [[nodiscard]] bool all(const size_t& start_range, const size_t& end_range, const bool& all_value = true) const {
+            return !any(start_range, end_range, !all_value);
         }
 
     private:
-        [[nodiscard]] size_t GetByteCount(const size_t& bit_count) {
-            size_t byte_count = 1;
-            if (bit_count >= 8) {
-                assert(1 + (bit_count - 1) / 8 > 0 && "Byte count must be always > 0");
-                byte_count = 1 + (bit_count - 1) / 8;
+        [[nodiscard]] static size_t GetWordCount(const size_t& bit_count) {
+            return (bit_count + WORD_BITS - 1) / WORD_BITS;
+        }
+        [[nodiscard]] static word_type RangeMask(const size_t& offset, const size_t& count) {
+            const word_type bits = count >= WORD_BITS ? ALL1 : ((BIT_RIGHT << count) - 1);
+            return bits << offset;
+        }
+
+        [[nodiscard]] size_t find_from(const size_t& bit_index) const {
+            size_t word_index = bit_index / WORD_BITS;
+            if (word_index >= _data.size()) return npos;
+
+            word_type word = _data[word_index] & (ALL1 << (bit_index % WORD_BITS));
+            while (word == ALL0) {
+                if (++word_index >= _data.size()) return npos;
+                word = _data[word_index];
             }
-            return byte_count;
+            return word_index * WORD_BITS + static_cast<size_t>(std::countr_zero(word));
+        }
+
+        void ClearUnusedBits() {
+            const size_t offset = _bit_size % WORD_BITS;
+            if (offset != 0) _data.back() &= RangeMask(0, offset);
         }
 
-        size_t _bit_size;
-        std::vector<uint8_t> _data;
+        size_t _bit_size = 0;
+        std::vector<word_type> _data;
 
-        static const uint8_t BIT_LEFT = 128; // 10000000
-        static const uint8_t BIT_RIGHT = 1; // 00000001
-        static const uint8_t ALL0 = 0; // 00000000
-        static const uint8_t ALL1 = 255; // 11111111
+        static constexpr word_type BIT_RIGHT = 1; // 0...01
+        static constexpr word_type ALL0 = 0; // 0...00
+        static constexpr word_type ALL1 = ~ALL0; // 1...11
     };
 }
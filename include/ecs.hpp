@@ -2,9 +2,23 @@
 
 #include "types.hpp"
 #include "dynamic_bitset.hpp"
+#include "signature.hpp"
 #include "utils.hpp"
 
 #include "base.hpp"
+#include "memory_stats.hpp"
+#include "snapshot.hpp"
+#include "hierarchy.hpp"
 #include "component_pool.hpp"
+#include "tag_component_pool.hpp"
+#include "soa_component_pool.hpp"
+#include "view.hpp"
+#include "group.hpp"
+#include "command_buffer.hpp"
+#include "observers.hpp"
 #include "world.hpp"
+#include "static_world.hpp"
+#include "thread_pool.hpp"
+#include "profiler.hpp"
 #include "systems.hpp"
+#include "sharded_world.hpp"
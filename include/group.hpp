@@ -0,0 +1,170 @@
+#pragma once
+
+#include "base.hpp"
+#include "component_pool.hpp"
+#include "soa_component_pool.hpp"
+#include "thread_pool.hpp"
+
+#include <tuple>
+#include <type_traits>
+#include <cassert>
+#include <numeric>
+
+namespace ecs {
+
+    // Interface Group
+
+    class IGroup {
+    public:
+        virtual ~IGroup() = default;
+
+        // called after component of owned type was inserted to entity
+        virtual void OnInsert(const entity entity) = 0;
+        // called before component of owned type will be removed from entity
+        virtual void OnRemove(const entity entity) = 0;
+        // collects members again, after owned pools were replaced (snapshot load)
+        virtual void Rebuild() = 0;
+        // members are at [0, size()) of owned pools
+        [[nodiscard]] virtual size_t size() const = 0;
+        // swaps members at positions in every owned pool, used to sort group
+        virtual void SwapAt(const size_t index1, const size_t index2) = 0;
+    };
+
+    // Owning Group
+    // Keeps entities with all TComponents packed at [0, size()) of every owned pool,
+    // in the same order, so iteration is a straight walk over arrays without membership tests.
+    // Each pool can be owned only by one group
+
+    template <typename... TComponents>
+    class Group final : public IGroup {
+        static_assert(sizeof...(TComponents) > 0, "Group requires at least one component");
+
+    public:
+        using value_type = std::tuple<typename pool_for<TComponents>::reference...>;
+
+        class iterator {
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using difference_type = std::ptrdiff_t;
+
+            iterator(const Group* group, size_t index) : _group{group}, _index{index} {}
+
+            value_type operator*() const { return _group->GetAt(_index); }
+            [[nodiscard]] entity GetEntity() const { return _group->GetEntityAt(_index); }
+
+            iterator& operator++() { // Prefix increment
+                ++_index;
+                return *this;
+            }
+            iterator operator++(int) { // Postfix increment
+                iterator tmp = *this;
+                ++(*this);
+                return tmp;
+            }
+
+            [[nodiscard]] friend bool operator== (const iterator& a, const iterator& b)
+                { return a._index == b._index; };
+            [[nodiscard]] friend bool operator!= (const iterator& a, const iterator& b)
+                { return a._index != b._index; };
+
+        private:
+            const Group* _group;
+            size_t _index;
+        };
+
+    public:
+        Group(pool_for<TComponents>*... pools) : _pools{pools...} {
+            assert(((pools != nullptr) && ...) && "Group requires registered components");
+            Rebuild();
+        }
+
+        void Rebuild() override {
+            _size = 0;
+            IComponentPool* lead = static_cast<IComponentPool*>(std::get<0>(_pools));
+            std::apply([&lead](auto... pools) {
+                ((lead = pools->size() < lead->size() ? static_cast<IComponentPool*>(pools) : lead), ...);
+            }, _pools);
+
+            // OnInsert swaps only with positions before index, which were already visited
+            for (size_t index = 0; index < lead->size(); index++)
+                OnInsert(lead->data()[index]);
+        }
+
+        void OnInsert(const entity entity) override {
+            if (!(std::get<pool_for<TComponents>*>(_pools)->ContainsComponent(entity) && ...)) return;
+            if (Contains(entity)) return;
+
+            (std::get<pool_for<TComponents>*>(_pools)->SwapIndexes(
+                std::get<pool_for<TComponents>*>(_pools)->GetIndex(entity), _size), ...);
+            ++_size;
+        }
+        void OnRemove(const entity entity) override {
+            if (!Contains(entity)) return;
+
+            --_size;
+            (std::get<pool_for<TComponents>*>(_pools)->SwapIndexes(
+                std::get<pool_for<TComponents>*>(_pools)->GetIndex(entity), _size), ...);
+        }
+
+        [[nodiscard]] bool Contains(const entity entity) const {
+            auto pool = std::get<0>(_pools);
+            return pool->ContainsComponent(entity) && pool->GetIndex(entity) < _size;
+        }
+
+        [[nodiscard]] entity GetEntityAt(const size_t index) const {
+            assert(index < _size && "Index out of range");
+            return std::get<0>(_pools)->GetEntityAt(index);
+        }
+        [[nodiscard]] value_type GetAt(const size_t index) const {
+            assert(index < _size && "Index out of range");
+            return value_type{std::get<pool_for<TComponents>*>(_pools)->GetComponentAt(index)...};
+        }
+
+        // func(entity, TComponents&...) or func(TComponents&...), SoA components are passed as proxy references
+        template <typename Func>
+        void Each(Func func) const {
+            for (size_t index = 0; index < _size; index++) {
+                if constexpr (std::is_invocable_v<Func, entity, typename pool_for<TComponents>::reference...>)
+                    func(std::get<0>(_pools)->GetEntityAt(index),
+                        std::get<pool_for<TComponents>*>(_pools)->GetComponentAt(index)...);
+                else
+                    func(std::get<pool_for<TComponents>*>(_pools)->GetComponentAt(index)...);
+            }
+        }
+
+        // Each, but chunks are processed on thread pool, chunks are split on cache lines of every owned pool
+        template <typename Func>
+        void ParallelEach(Func func, const size_t grain = DEFAULT_PARALLEL_GRAIN, 
+            ThreadPool& thread_pool = ThreadPool::Shared()) const {
+            size_t alignment = 1;
+            ((alignment = std::lcm(alignment, pool_for<TComponents>::PARALLEL_ALIGNMENT)), ...);
+
+            auto chunk = [this, &func](const size_t begin, const size_t end) {
+                for (size_t index = begin; index < end; index++) {
+                    if constexpr (std::is_invocable_v<Func, entity, typename pool_for<TComponents>::reference...>)
+                        func(std::get<0>(_pools)->GetEntityAt(index),
+                            std::get<pool_for<TComponents>*>(_pools)->GetComponentAt(index)...);
+                    else
+                        func(std::get<pool_for<TComponents>*>(_pools)->GetComponentAt(index)...);
+                }
+            };
+            thread_pool.ParallelChunks(_size, grain, alignment, chunk);
+        }
+
+        [[nodiscard]] size_t size() const override { return _size; }
+
+        void SwapAt(const size_t index1, const size_t index2) override {
+            assert(index1 < _size && index2 < _size && "Index out of range");
+            (std::get<pool_for<TComponents>*>(_pools)->SwapIndexes(index1, index2), ...);
+        }
+
+    public: // Iterators
+
+        [[nodiscard]] iterator begin() const { return iterator{this, 0}; }
+        [[nodiscard]] iterator end() const { return iterator{this, _size}; }
+
+    private:
+        std::tuple<pool_for<TComponents>*...> _pools;
+        size_t _size = 0;
+    };
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include "base.hpp"
+
+#include <cstdint>
+
+namespace ecs {
+
+    // Hierarchy
+    // Parent/child relation as intrusive lists: every node links its parent, first child and siblings,
+    // so reparenting is O(1) unlink and link. It is managed with World::SetParent and destroyed with subtree
+    // in World::DestroyEntity, don't insert or remove it directly.
+    // World::SortHierarchy reorders its pool, so parents are before children in dense order and propagation
+    // (of transforms for example) is one forward pass over pool
+
+    struct Hierarchy {
+        entity parent = NULL_ENTITY;
+        entity first_child = NULL_ENTITY; // last attached child, children are in reverse order of SetParent
+        entity prev_sibling = NULL_ENTITY;
+        entity next_sibling = NULL_ENTITY;
+        uint32_t children = 0;
+    };
+
+    enum class HierarchyOrder {
+        BreadthFirst, // roots, then their children, then grandchildren...
+        DepthFirst, // pre-order, every subtree is contiguous
+    };
+}
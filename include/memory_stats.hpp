@@ -0,0 +1,80 @@
+#pragma once
+
+#include "base.hpp"
+#include "types.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <memory_resource>
+#include <utility>
+#include <vector>
+
+namespace ecs {
+
+    // Memory of one component pool, reserved includes used
+    struct PoolStats {
+        size_t count = 0; // live components
+        size_t capacity = 0; // components which fit without allocation
+        size_t sparse_bytes = 0; // entity index -> component index, sized to entities range
+        size_t used_bytes = 0; // sparse + live components with their entities and ticks
+        size_t reserved_bytes = 0;
+    };
+
+    // Memory of world, pool bytes are included in totals
+    struct WorldStats {
+        uint32_t entities_count = 0;
+        uint32_t entities_capacity = 0;
+        size_t free_entities = 0; // destroyed entity slots waiting in free list
+        double fragmentation = 0; // free / (free + alive) entity slots, share of holes in index range
+        size_t signature_bytes = 0; // reserved by signature matrix, signature::CAPACITY bits per entity
+        size_t entity_table_bytes = 0; // reserved by entities and free list
+        size_t used_bytes = 0;
+        size_t reserved_bytes = 0;
+        std::vector<std::pair<type_index, PoolStats>> pools; // in registration order
+    };
+
+    // Counting Memory Resource
+    // Forwards to upstream resource and counts allocations, pass it to World to see all its allocations
+
+    class CountingMemoryResource final : public std::pmr::memory_resource {
+    public:
+        explicit CountingMemoryResource(std::pmr::memory_resource* upstream = std::pmr::get_default_resource())
+            : _upstream{upstream} { }
+
+        [[nodiscard]] size_t GetAllocationsCount() const { return _allocations.load(std::memory_order_relaxed); }
+        [[nodiscard]] size_t GetDeallocationsCount() const { return _deallocations.load(std::memory_order_relaxed); }
+        // currently allocated
+        [[nodiscard]] size_t GetAllocatedBytes() const { return _bytes.load(std::memory_order_relaxed); }
+        [[nodiscard]] size_t GetPeakBytes() const { return _peak_bytes.load(std::memory_order_relaxed); }
+        // allocated since creation, freed memory is not subtracted
+        [[nodiscard]] size_t GetTotalBytes() const { return _total_bytes.load(std::memory_order_relaxed); }
+
+        void ResetPeak() { _peak_bytes.store(GetAllocatedBytes(), std::memory_order_relaxed); }
+
+    private:
+        void* do_allocate(const size_t bytes, const size_t alignment) override {
+            void* ptr = _upstream->allocate(bytes, alignment);
+            _allocations.fetch_add(1, std::memory_order_relaxed);
+            _total_bytes.fetch_add(bytes, std::memory_order_relaxed);
+            const size_t current = _bytes.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+            size_t peak = _peak_bytes.load(std::memory_order_relaxed);
+            while (peak < current && !_peak_bytes.compare_exchange_weak(peak, current, std::memory_order_relaxed)) {}
+            return ptr;
+        }
+        void do_deallocate(void* ptr, const size_t bytes, const size_t alignment) override {
+            _upstream->deallocate(ptr, bytes, alignment);
+            _deallocations.fetch_add(1, std::memory_order_relaxed);
+            _bytes.fetch_sub(bytes, std::memory_order_relaxed);
+        }
+        [[nodiscard]] bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+            return this == &other;
+        }
+
+        std::pmr::memory_resource* _upstream;
+        std::atomic<size_t> _allocations{0};
+        std::atomic<size_t> _deallocations{0};
+        std::atomic<size_t> _bytes{0};
+        std::atomic<size_t> _peak_bytes{0};
+        std::atomic<size_t> _total_bytes{0};
+    };
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "base.hpp"
+#include "component_pool.hpp"
+#include "soa_component_pool.hpp"
+
+#include <functional>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace ecs {
+
+    // Interface Component Observers
+    // Events of one component type are recorded to plain arrays and delivered to observers in batches
+    // at flush points, nothing is recorded until first observer is added.
+    // Batches are delivered in order: added, updated, removed. Entities of added/updated batches
+    // can be removed or destroyed before delivery, check ContainsComponent if it matters
+
+    class IComponentObservers {
+    public:
+        using entities_observer = std::function<void(std::span<const entity> entities)>;
+
+        virtual ~IComponentObservers() = default;
+
+        void OnAdd(entities_observer observer) { _on_add.push_back(std::move(observer)); }
+        void OnUpdate(entities_observer observer) { _on_update.push_back(std::move(observer)); }
+
+        void RecordAdd(const entity entity) { if (!_on_add.empty()) _added.push_back(entity); }
+        void RecordUpdate(const entity entity) { if (!_on_update.empty()) _updated.push_back(entity); }
+        // called before component is removed from pool, component is moved out for remove observers
+        virtual void RecordRemove(const entity entity, IComponentPool& pool) = 0;
+
+        // observers can change world, events recorded by them are delivered on next flush
+        virtual void Deliver() {
+            Deliver(_added, _on_add);
+            Deliver(_updated, _on_update);
+        }
+
+    private:
+        void Deliver(std::vector<entity>& pending, const std::vector<entities_observer>& observers) {
+            if (pending.empty()) return;
+            std::swap(pending, _delivered);
+            for (auto& observer : observers) observer(_delivered);
+            _delivered.clear();
+        }
+
+        std::vector<entities_observer> _on_add{};
+        std::vector<entities_observer> _on_update{};
+        std::vector<entity> _added{};
+        std::vector<entity> _updated{};
+        std::vector<entity> _delivered{};
+    };
+
+    // Component Observers
+
+    template <typename TComponent>
+    class ComponentObservers final : public IComponentObservers {
+    public:
+        // components[i] was removed from entities[i], observers can move out of components
+        using remove_observer = std::function<void(std::span<const entity> entities, std::span<TComponent> components)>;
+
+        void OnRemove(remove_observer observer) { _on_remove.push_back(std::move(observer)); }
+
+        void RecordRemove(const entity entity, IComponentPool& pool) override {
+            if (_on_remove.empty()) return;
+            _removed.push_back(entity);
+            _removed_components.push_back(TComponent(std::move(static_cast<pool_for<TComponent>&>(pool).GetComponent(entity))));
+        }
+
+        void Deliver() override {
+            IComponentObservers::Deliver();
+            if (_removed.empty()) return;
+
+            std::swap(_removed, _delivered_removed);
+            std::swap(_removed_components, _delivered_components);
+            for (auto& observer : _on_remove) observer(_delivered_removed, _delivered_components);
+            _delivered_removed.clear();
+            _delivered_components.clear();
+        }
+
+    private:
+        std::vector<remove_observer> _on_remove{};
+        std::vector<entity> _removed{};
+        std::vector<TComponent> _removed_components{};
+        std::vector<entity> _delivered_removed{};
+        std::vector<TComponent> _delivered_components{};
+    };
+}
@@ -0,0 +1,206 @@
+#pragma once
+
+// Profiling of systems, compiled out unless YAECS_PROFILE is 1 (cmake option YAECS_PROFILE)
+#ifndef YAECS_PROFILE
+#define YAECS_PROFILE 0
+#endif
+
+#if YAECS_PROFILE
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <typeinfo>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#if defined(__GNUG__)
+#include <cxxabi.h>
+#endif
+
+namespace ecs {
+
+    // Statistics of one system, written only by thread which runs system,
+    // read them at sync points (after collection execution)
+
+    struct SystemProfile {
+        static constexpr size_t WINDOW = 128; // runs in rolling window
+
+        uint64_t calls = 0;
+        uint64_t entities = 0; // reported by system with AddProcessed
+        uint64_t total_ns = 0;
+        uint64_t last_ns = 0;
+
+        void Add(const uint64_t duration_ns, const uint64_t processed) {
+            calls++;
+            entities += processed;
+            total_ns += duration_ns;
+            last_ns = duration_ns;
+            _window[_window_position] = duration_ns;
+            _window_position = (_window_position + 1) % WINDOW;
+            _window_size = std::min(_window_size + 1, WINDOW);
+        }
+
+        // rolling statistics over last WINDOW runs
+        [[nodiscard]] uint64_t Min() const {
+            return _window_size ? *std::min_element(_window.begin(), _window.begin() + _window_size) : 0;
+        }
+        [[nodiscard]] uint64_t Max() const {
+            return _window_size ? *std::max_element(_window.begin(), _window.begin() + _window_size) : 0;
+        }
+        // percentile in [0, 100], nearest rank
+        [[nodiscard]] uint64_t Percentile(const double percentile) const {
+            if (_window_size == 0) return 0;
+            std::array<uint64_t, WINDOW> sorted = _window;
+            const size_t rank = std::min(_window_size - 1, static_cast<size_t>(percentile / 100.0 * _window_size));
+            std::nth_element(sorted.begin(), sorted.begin() + rank, sorted.begin() + _window_size);
+            return sorted[rank];
+        }
+        [[nodiscard]] uint64_t P50() const { return Percentile(50); }
+        [[nodiscard]] uint64_t P99() const { return Percentile(99); }
+
+    private:
+        std::array<uint64_t, WINDOW> _window{};
+        size_t _window_position = 0;
+        size_t _window_size = 0;
+    };
+
+    // Profiler
+    // Every thread records events to own ring buffer without locks, buffers are linked into
+    // lock-free list on first record of thread. Export reads buffers, call it at sync points
+
+    class Profiler {
+    public:
+        struct Event {
+            const char* name; // interned, lives as long as profiler
+            const char* category;
+            uint64_t begin_ns;
+            uint64_t end_ns;
+            uint64_t entities;
+        };
+
+        static constexpr size_t RECORDER_CAPACITY = 1 << 16; // last events per thread
+
+        Profiler() : _start{std::chrono::steady_clock::now()} { }
+        ~Profiler() {
+            Recorder* recorder = _recorders.load(std::memory_order_acquire);
+            while (recorder) delete std::exchange(recorder, recorder->next);
+        }
+
+        Profiler(const Profiler&) = delete;
+        Profiler& operator=(const Profiler&) = delete;
+
+        [[nodiscard]] static Profiler& Shared() {
+            static Profiler profiler{};
+            return profiler;
+        }
+
+        // ns since profiler creation
+        [[nodiscard]] uint64_t Now() const {
+            return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - _start).count());
+        }
+
+        // stable name for events, locks, call it once per name
+        [[nodiscard]] const char* Intern(const std::string& name) {
+            std::lock_guard lock{_names_mutex};
+            return _names.insert(name).first->c_str();
+        }
+        [[nodiscard]] static std::string TypeName(const std::type_info& type) {
+#if defined(__GNUG__)
+            int status = 0;
+            std::unique_ptr<char, void(*)(void*)> demangled{abi::__cxa_demangle(type.name(), nullptr, nullptr, &status), std::free};
+            if (status == 0 && demangled) return demangled.get();
+#endif
+            return type.name();
+        }
+
+        void Record(const Event& event, SystemProfile* profile = nullptr) {
+            Recorder& recorder = CurrentRecorder();
+            const size_t head = recorder.head.load(std::memory_order_relaxed);
+            recorder.events[head % RECORDER_CAPACITY] = event;
+            recorder.head.store(head + 1, std::memory_order_release);
+            if (profile) profile->Add(event.end_ns - event.begin_ns, event.entities);
+        }
+
+        // drops recorded events
+        void Clear() {
+            for (Recorder* recorder = _recorders.load(std::memory_order_acquire); recorder; recorder = recorder->next)
+                recorder->tail = recorder->head.load(std::memory_order_acquire);
+        }
+
+        // Chrome trace_event JSON, open with chrome://tracing or ui.perfetto.dev
+        void WriteChromeTrace(std::ostream& out) const {
+            out << "{\"traceEvents\":[";
+            bool first = true;
+            for (Recorder* recorder = _recorders.load(std::memory_order_acquire); recorder; recorder = recorder->next) {
+                const size_t head = recorder->head.load(std::memory_order_acquire);
+                const size_t begin = std::max(recorder->tail, head > RECORDER_CAPACITY ? head - RECORDER_CAPACITY : 0);
+                for (size_t index = begin; index < head; index++) {
+                    const Event& event = recorder->events[index % RECORDER_CAPACITY];
+                    out << (first ? "\n" : ",\n") << "{\"name\":\"" << Escaped(event.name) << "\",\"cat\":\"" << event.category
+                        << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << recorder->thread
+                        << ",\"ts\":" << event.begin_ns / 1000.0 << ",\"dur\":" << (event.end_ns - event.begin_ns) / 1000.0
+                        << ",\"args\":{\"entities\":" << event.entities << "}}";
+                    first = false;
+                }
+            }
+            out << "\n],\"displayTimeUnit\":\"ms\"}\n";
+        }
+        bool WriteChromeTrace(const std::string& path) const {
+            std::ofstream file{path};
+            if (!file) return false;
+            WriteChromeTrace(file);
+            return static_cast<bool>(file);
+        }
+
+    private:
+        struct Recorder {
+            std::unique_ptr<Event[]> events = std::make_unique<Event[]>(RECORDER_CAPACITY);
+            std::atomic<size_t> head{0}; // written events, only owner thread writes
+            size_t tail = 0; // first event after Clear
+            uint32_t thread = 0;
+            Recorder* next = nullptr;
+        };
+
+        Recorder& CurrentRecorder() {
+            thread_local Recorder* recorder = nullptr;
+            thread_local const Profiler* owner = nullptr;
+            if (recorder && owner == this) return *recorder;
+
+            recorder = new Recorder{};
+            owner = this;
+            recorder->thread = _threads.fetch_add(1, std::memory_order_relaxed);
+            recorder->next = _recorders.load(std::memory_order_relaxed);
+            while (!_recorders.compare_exchange_weak(recorder->next, recorder, std::memory_order_release, std::memory_order_relaxed)) {}
+            return *recorder;
+        }
+
+        static std::string Escaped(const char* name) {
+            std::string escaped;
+            for (const char* c = name; *c; c++) {
+                if (*c == '"' || *c == '\\') escaped.push_back('\\');
+                escaped.push_back(*c);
+            }
+            return escaped;
+        }
+
+        std::chrono::steady_clock::time_point _start;
+        std::atomic<Recorder*> _recorders{nullptr};
+        std::atomic<uint32_t> _threads{0};
+
+        std::mutex _names_mutex;
+        std::unordered_set<std::string> _names;
+    };
+}
+
+#endif
@@ -0,0 +1,289 @@
+#pragma once
+
+#include "base.hpp"
+#include "types.hpp"
+#include "command_buffer.hpp"
+#include "world.hpp"
+#include "hierarchy.hpp"
+#include "systems.hpp"
+#include "thread_pool.hpp"
+
+#include <cassert>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <span>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace ecs {
+
+    // Sharded World
+    // N independent worlds (shards), partitioned spatially or by key. Every shard owns its entities, pools
+    // and systems, so shards are stepped in parallel without shared state and existing systems run per shard
+    // unchanged. Entities move between shards only at sync points: Migrate queues entity, Sync moves it
+    // with all components in batch. Migrated entity gets new handle in target shard, old handle becomes stale.
+    // Components must be registered with ShardedWorld, so component indexes are the same in all shards.
+    // Hierarchy is registered in every shard up front, its links are local to shard, so migrated entity
+    // leaves hierarchy of source shard and its children become roots there
+
+    class ShardedWorld {
+    public:
+        // entity of one shard
+        struct Handle {
+            uint32_t shard;
+            ecs::entity entity;
+
+            [[nodiscard]] friend bool operator==(const Handle&, const Handle&) = default;
+        };
+
+        // to.entity is NULL_ENTITY if entity didn't exist at sync
+        struct Migration {
+            Handle from;
+            Handle to;
+        };
+
+    public:
+        // resource is used by all shards
+        explicit ShardedWorld(uint32_t shards_count,
+            uint32_t default_entities_capacity = DEFAULT_ENTITIES_CAPACITY,
+            uint32_t default_entity_capacity = DEFAULT_ENTITY_CAPACITY,
+            std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+            : _queues{std::make_unique<Queue[]>(shards_count)}, _buffers(size_t{shards_count} * shards_count),
+            _created_counts(size_t{shards_count} * shards_count, 0) {
+            assert(shards_count > 0 && "ShardedWorld requires at least one shard");
+
+            _shards.reserve(shards_count);
+            _systems.reserve(shards_count);
+            for (uint32_t shard = 0; shard < shards_count; shard++) {
+                _shards.push_back(std::make_unique<World>(default_entities_capacity, default_entity_capacity, resource));
+                _systems.push_back(std::make_unique<Systems>(*_shards.back()));
+                _shards.back()->RegisterComponent<Hierarchy>();
+            }
+            _stages.push_back(nullptr);
+        }
+
+        ShardedWorld(const ShardedWorld&) = delete;
+        ShardedWorld& operator=(const ShardedWorld&) = delete;
+
+    public: // Shards
+
+        [[nodiscard]] uint32_t GetShardsCount() const { return static_cast<uint32_t>(_shards.size()); }
+        [[nodiscard]] World& GetShard(const uint32_t shard) { return *_shards[shard]; }
+        [[nodiscard]] const World& GetShard(const uint32_t shard) const { return *_shards[shard]; }
+        // systems of shard are created once per shard, they see only their shard
+        [[nodiscard]] Systems& GetSystems(const uint32_t shard) { return *_systems[shard]; }
+
+        // one task per shard, nullptr to step shards sequentially
+        void SetThreadPool(ThreadPool* thread_pool) { _thread_pool = thread_pool; }
+
+        // func(World&, uint32_t shard) for every shard in parallel, func must touch only given shard
+        template <typename Func>
+        void EachShard(Func func) {
+            auto step = [this, &func](const size_t shard) { func(*_shards[shard], static_cast<uint32_t>(shard)); };
+            if (_thread_pool) _thread_pool->ParallelFor(_shards.size(), step);
+            else for (size_t shard = 0; shard < _shards.size(); shard++) step(shard);
+        }
+
+        // executes collection of every shard, shards run in parallel
+        template <typename TSystemInterface> requires is_system_interface<TSystemInterface>
+        void ExecuteCollectionInterface() {
+            EachShard([this](World&, const uint32_t shard) { _systems[shard]->ExecuteCollectionInterface<TSystemInterface>(); });
+        }
+
+    public: // Components
+
+        template <typename TComponent>
+        void RegisterComponent() {
+            for (auto& shard : _shards) {
+                shard->RegisterComponent<TComponent>();
+                assert(shard->GetComponentTypeIndex<TComponent>() == _stages.size() && "Components must be registered only with ShardedWorld");
+            }
+            _stages.push_back(&Stage<TComponent>);
+        }
+
+    public: // Entities
+
+        [[nodiscard]] Handle CreateEntity(const uint32_t shard) {
+            assert(shard < _shards.size() && "Shard out of range");
+            return Handle{shard, _shards[shard]->CreateEntity()};
+        }
+        void DestroyEntity(const Handle handle) { _shards[handle.shard]->DestroyEntity(handle.entity); }
+        [[nodiscard]] bool ExistsEntity(const Handle handle) const {
+            return handle.shard < _shards.size() && _shards[handle.shard]->ExistsEntity(handle.entity);
+        }
+        [[nodiscard]] uint32_t GetEntitiesCount() const {
+            uint32_t count = 0;
+            for (const auto& shard : _shards) count += shard->GetEntitiesCount();
+            return count;
+        }
+
+        template <typename TComponent>
+        void AddComponent(const Handle handle, TComponent component) {
+            _shards[handle.shard]->AddComponent(handle.entity, std::move(component));
+        }
+        template <typename TComponent>
+        void InsertComponent(const Handle handle, TComponent component) {
+            _shards[handle.shard]->InsertComponent(handle.entity, std::move(component));
+        }
+        // as World::GetComponent, GetComponent<const TComponent> is read only
+        template <typename TComponent>
+        [[nodiscard]] decltype(auto) GetComponent(const Handle handle) {
+            return _shards[handle.shard]->GetComponent<TComponent>(handle.entity);
+        }
+        template <typename TComponent>
+        [[nodiscard]] bool ContainsComponent(const Handle handle) {
+            return _shards[handle.shard]->ContainsComponent<TComponent>(handle.entity);
+        }
+
+    public: // Queries
+
+        // Read only query over all shards: func(Handle, const TComponents&...) or func(const TComponents&...),
+        // SoA components as const proxy references. Shards are visited in order
+        template <typename... TComponents, typename Func>
+        void Each(Func func) {
+            for (uint32_t shard = 0; shard < _shards.size(); shard++) EachIn<TComponents...>(shard, func);
+        }
+        // Each, but one task per shard, so func is called concurrently for different shards
+        template <typename... TComponents, typename Func>
+        void ParallelEach(Func func) {
+            EachShard([this, &func](World&, const uint32_t shard) { EachIn<TComponents...>(shard, func); });
+        }
+
+    public: // Migration
+
+        // entity is moved to target shard at next Sync, can be called from systems of source shard
+        void Migrate(const Handle handle, const uint32_t target) {
+            assert(handle.shard < _shards.size() && target < _shards.size() && "Shard out of range");
+            Queue& queue = _queues[handle.shard];
+            std::lock_guard lock{queue.mutex};
+            queue.migrations.push_back(PendingMigration{handle.entity, target});
+        }
+
+        // Queues migration of every entity with TComponent, whose key(const TComponent&) isn't its shard.
+        // Key is called in parallel for different shards
+        template <typename TComponent, typename Func>
+        void MigrateBy(Func key) {
+            EachShard([this, &key](World& world, const uint32_t shard) {
+                world.View<const TComponent>().Each([&](const ecs::entity entity, const auto& component) {
+                    const uint32_t target = key(component);
+                    if (target != shard) Migrate(Handle{shard, entity}, target);
+                });
+            });
+        }
+
+        // Sync point, shards must not be stepped. Applies queued migrations, result is in order of source
+        // shards and queue order inside shard, it is valid until next Sync.
+        // Source shards stage components (moved, so OnRemove observers of source see moved-from values)
+        // to command buffer per pair of shards and destroy entities, then target shards flush their buffers
+        // in source order. Both phases are parallel over shards and every shard is touched by one task
+        std::span<const Migration> Sync() {
+            const size_t count = _shards.size();
+            _migrated.clear();
+            _migrated_offsets.assign(count + 1, 0);
+            for (size_t shard = 0; shard < count; shard++)
+                _migrated_offsets[shard + 1] = _migrated_offsets[shard] + _queues[shard].migrations.size();
+            if (_migrated_offsets[count] == 0) return _migrated;
+            _migrated.resize(_migrated_offsets[count]);
+
+            auto stage = [this, count](World& world, const uint32_t shard) {
+                auto& migrations = _queues[shard].migrations;
+                Migration* migrated = _migrated.data() + _migrated_offsets[shard];
+                for (size_t i = 0; i < migrations.size(); i++) {
+                    const auto [entity, target] = migrations[i];
+                    migrated[i] = Migration{Handle{shard, entity}, Handle{target, NULL_ENTITY}};
+                    if (!world.ExistsEntity(entity)) continue;
+                    if (target == shard) {
+                        migrated[i].to.entity = entity;
+                        continue;
+                    }
+
+                    const size_t pair = shard * count + target;
+                    CommandBuffer& buffer = _buffers[pair];
+                    const ecs::entity pending = buffer.CreateEntity();
+                    const signature& signature = world.GetSignature(entity);
+                    for (size_t index = signature.find_first(); index != signature::npos; index = signature.find_next(index)) {
+                        assert(index < _stages.size() && "Components must be registered only with ShardedWorld");
+                        if (_stages[index]) _stages[index](world, entity, buffer, pending);
+                    }
+                    world.Detach(entity); // children stay in source shard as roots, they aren't destroyed with it
+                    world.DestroyEntity(entity);
+                    migrated[i].to.entity = pending;
+                    _created_counts[pair]++;
+                }
+                migrations.clear();
+            };
+            EachShard(stage);
+
+            // created entities of target are concatenated in source order, offsets map pending entities to them
+            _created.resize(count);
+            _created_offsets.resize(count * count);
+            auto flush = [this, count](World& world, const uint32_t shard) {
+                std::vector<CommandBuffer*> buffers;
+                size_t offset = 0;
+                for (size_t source = 0; source < count; source++) {
+                    const size_t pair = source * count + shard;
+                    _created_offsets[pair] = offset;
+                    offset += std::exchange(_created_counts[pair], 0);
+                    if (!_buffers[pair].empty()) buffers.push_back(&_buffers[pair]);
+                }
+                if (buffers.empty()) return;
+                world.Flush(buffers);
+                auto created = world.GetFlushCreated();
+                _created[shard].assign(created.begin(), created.end());
+            };
+            EachShard(flush);
+
+            for (auto& migration : _migrated) {
+                if (migration.to.entity == NULL_ENTITY || !CommandBuffer::IsPending(migration.to.entity)) continue;
+                const size_t pair = migration.from.shard * count + migration.to.shard;
+                migration.to.entity = _created[migration.to.shard][_created_offsets[pair] + GetEntityIndex(migration.to.entity)];
+            }
+            return _migrated;
+        }
+
+    private:
+        struct PendingMigration {
+            ecs::entity entity;
+            uint32_t target;
+        };
+
+        struct alignas(CACHE_LINE_SIZE) Queue {
+            std::mutex mutex;
+            std::vector<PendingMigration> migrations;
+        };
+
+        // moves component of entity to buffer as insert for pending entity
+        using stage_function = void (*)(World& world, ecs::entity entity, CommandBuffer& buffer, ecs::entity pending);
+
+        template <typename TComponent>
+        static void Stage(World& world, const ecs::entity entity, CommandBuffer& buffer, const ecs::entity pending) {
+            buffer.InsertComponent(pending, TComponent(std::move(world.GetComponent<TComponent>(entity))));
+        }
+
+        template <typename... TComponents, typename Func>
+        void EachIn(const uint32_t shard, Func& func) {
+            _shards[shard]->View<const TComponents...>().Each([&](const ecs::entity entity, const auto&... components) {
+                if constexpr (std::is_invocable_v<Func&, Handle, decltype(components)...>)
+                    func(Handle{shard, entity}, components...);
+                else
+                    func(components...);
+            });
+        }
+
+        std::vector<std::unique_ptr<World>> _shards; // worlds never move, systems refer to them
+        std::vector<std::unique_ptr<Systems>> _systems;
+        ThreadPool* _thread_pool = &ThreadPool::Shared();
+
+        std::vector<stage_function> _stages{}; // by component index, nullptr for components, which aren't migrated
+        std::unique_ptr<Queue[]> _queues; // by source shard
+        std::vector<CommandBuffer> _buffers; // by source * shards count + target
+        std::vector<uint32_t> _created_counts; // pending entities by pair of shards
+        std::vector<size_t> _created_offsets{}; // by pair of shards
+        std::vector<std::vector<ecs::entity>> _created{}; // by target shard
+        std::vector<Migration> _migrated{};
+        std::vector<size_t> _migrated_offsets{}; // by source shard
+    };
+}
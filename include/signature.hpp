@@ -0,0 +1,117 @@
+#pragma once
+
+#include <array>
+#include <cassert>
+#include <cstdint>
+#include <bit>
+
+// Count of uint64_t words in entity signature, limits count of registered components per world
+// (1 = 64 components, 2 = 128 components)
+#ifndef YAECS_SIGNATURE_WORDS
+#define YAECS_SIGNATURE_WORDS 2
+#endif
+
+namespace ecs {
+
+    // Fixed width bitset with inline storage, same bit layout and naming as dynamic_bitset.
+    // World stores them in one contiguous vector indexed by entity (signature matrix),
+    // so creating entity doesn't allocate and mask scans are linear in memory
+
+    template <size_t Words>
+    class basic_signature {
+    public:
+        using word_type = std::uint64_t;
+        static constexpr size_t WORD_BITS = 64;
+        static constexpr size_t WORDS = Words;
+        static constexpr size_t CAPACITY = Words * WORD_BITS;
+        static constexpr size_t npos = static_cast<size_t>(-1);
+
+    public:
+        constexpr void set(const size_t& bit_index, const bool& value = true) {
+            assert(bit_index < CAPACITY && "Bit index out of range");
+
+            word_type bitfield = BIT_RIGHT << (bit_index % WORD_BITS);
+            if (value)
+                _data[bit_index / WORD_BITS] |= bitfield;
+            else
+                _data[bit_index / WORD_BITS] &= ~bitfield;
+        }
+        [[nodiscard]] constexpr bool get(const size_t& bit_index) const {
+            assert(bit_index < CAPACITY && "Bit index out of range");
+            return (_data[bit_index / WORD_BITS] >> (bit_index % WORD_BITS)) & BIT_RIGHT;
+        }
+        [[nodiscard]] bool operator[](const size_t& bit_index) const {
+            return get(bit_index);
+        }
+
+        [[nodiscard]] bool operator==(const basic_signature& other) const = default;
+
+        void reset() { _data.fill(ALL0); }
+
+    public: // Bulk operations
+
+        basic_signature& operator&=(const basic_signature& other) {
+            for (size_t i = 0; i < Words; i++) _data[i] &= other._data[i];
+            return *this;
+        }
+        basic_signature& operator|=(const basic_signature& other) {
+            for (size_t i = 0; i < Words; i++) _data[i] |= other._data[i];
+            return *this;
+        }
+        basic_signature& operator-=(const basic_signature& other) {
+            for (size_t i = 0; i < Words; i++) _data[i] &= ~other._data[i];
+            return *this;
+        }
+
+        [[nodiscard]] bool intersects(const basic_signature& other) const {
+            word_type rest = ALL0;
+            for (size_t i = 0; i < Words; i++) rest |= _data[i] & other._data[i];
+            return rest != ALL0;
+        }
+        [[nodiscard]] bool is_subset_of(const basic_signature& other) const {
+            word_type rest = ALL0;
+            for (size_t i = 0; i < Words; i++) rest |= _data[i] & ~other._data[i];
+            return rest == ALL0;
+        }
+
+        [[nodiscard]] size_t count() const {
+            size_t result = 0;
+            for (size_t i = 0; i < Words; i++) result += static_cast<size_t>(std::popcount(_data[i]));
+            return result;
+        }
+        [[nodiscard]] bool any() const {
+            word_type rest = ALL0;
+            for (size_t i = 0; i < Words; i++) rest |= _data[i];
+            return rest != ALL0;
+        }
+        [[nodiscard]] bool none() const { return !any(); }
+
+        [[nodiscard]] size_t find_first() const { return find_from(0); }
+        [[nodiscard]] size_t find_next(const size_t& bit_index) const {
+            if (bit_index + 1 >= CAPACITY) return npos;
+            return find_from(bit_index + 1);
+        }
+
+        [[nodiscard]] size_t size() const { return CAPACITY; }
+        [[nodiscard]] const std::array<word_type, Words>& data() const { return _data; }
+
+    private:
+        [[nodiscard]] size_t find_from(const size_t& bit_index) const {
+            size_t word_index = bit_index / WORD_BITS;
+            word_type word = _data[word_index] & (ALL1 << (bit_index % WORD_BITS));
+            while (word == ALL0) {
+                if (++word_index >= Words) return npos;
+                word = _data[word_index];
+            }
+            return word_index * WORD_BITS + static_cast<size_t>(std::countr_zero(word));
+        }
+
+        std::array<word_type, Words> _data{};
+
+        static constexpr word_type BIT_RIGHT = 1; // 0...01
+        static constexpr word_type ALL0 = 0; // 0...00
+        static constexpr word_type ALL1 = ~ALL0; // 1...11
+    };
+
+    using signature = basic_signature<YAECS_SIGNATURE_WORDS>;
+}
@@ -0,0 +1,276 @@
+#pragma once
+
+#include "base.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <ostream>
+#include <span>
+#include <string>
+#include <typeinfo>
+#include <utility>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define YAECS_SNAPSHOT_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#define YAECS_SNAPSHOT_MMAP 0
+#endif
+
+namespace ecs {
+
+    // Snapshot format (native endianness, version must match):
+    //     SnapshotHeader, entity table, signature matrix, then SnapshotPoolHeader and payload per pool.
+    // Pool payload is packed arrays in dense order: entities, added ticks, changed ticks, components
+    // (one block per member for SoA pools). Every block starts at SNAPSHOT_ALIGNMENT offset of file,
+    // so blocks of mapped file are aligned for their types
+
+    static constexpr char SNAPSHOT_MAGIC[8] = {'Y', 'A', 'E', 'C', 'S', 'S', 'N', 'P'};
+    static constexpr uint32_t SNAPSHOT_VERSION = 1;
+    static constexpr size_t SNAPSHOT_ALIGNMENT = CACHE_LINE_SIZE;
+
+    struct SnapshotHeader {
+        char magic[8];
+        uint32_t version;
+        uint32_t signature_words;
+        uint32_t entities_size; // slots of entity table, alive and free
+        uint32_t entities_count; // alive
+        uint32_t free_entity; // head of free list
+        tick current_tick;
+        uint32_t pools_count;
+        uint32_t reserved;
+    };
+
+    struct SnapshotPoolHeader {
+        static constexpr uint32_t RAW = 1; // components are written, not trivially copyable ones are skipped
+
+        uint64_t type_hash; // see SnapshotTypeHash
+        uint64_t payload_bytes; // after header
+        uint32_t component_size;
+        uint32_t count;
+        uint32_t flags;
+        uint32_t reserved;
+    };
+
+    // Type id, which is stable between runs of the same build (TypeIndexator values depend on first use order)
+    template <typename TComponent>
+    [[nodiscard]] uint64_t SnapshotTypeHash() {
+        uint64_t hash = 14695981039346656037ull; // FNV-1a
+        for (const char* c = typeid(TComponent).name(); *c; c++)
+            hash = (hash ^ static_cast<unsigned char>(*c)) * 1099511628211ull;
+        return (hash ^ sizeof(TComponent)) * 1099511628211ull;
+    }
+
+    [[nodiscard]] constexpr size_t SnapshotAligned(const size_t bytes) {
+        return (bytes + SNAPSHOT_ALIGNMENT - 1) / SNAPSHOT_ALIGNMENT * SNAPSHOT_ALIGNMENT;
+    }
+
+    // Delta format (between base snapshot and current world, native endianness):
+    //     DeltaHeader, DeltaSlot per changed entity slot, index and value per changed signature row,
+    //     then DeltaPoolHeader and records per pool. Record is DeltaRecord and packed component bytes
+    //     XORed with base component (with zeros for inserts), encoded with DeltaEncode
+
+    static constexpr char DELTA_MAGIC[8] = {'Y', 'A', 'E', 'C', 'S', 'D', 'L', 'T'};
+    static constexpr uint32_t DELTA_VERSION = 1;
+
+    struct DeltaHeader {
+        char magic[8];
+        uint32_t version;
+        uint32_t signature_words;
+        tick base_tick;
+        tick current_tick;
+        uint32_t entities_size;
+        uint32_t entities_count;
+        uint32_t free_entity;
+        uint32_t slots_count;
+        uint32_t signatures_count;
+        uint32_t pools_count;
+    };
+
+    struct DeltaSlot {
+        uint64_t index;
+        entity slot; // alive entity or free list link
+    };
+
+    struct DeltaPoolHeader {
+        uint64_t type_hash; // see SnapshotTypeHash
+        uint64_t payload_bytes; // records after header
+        uint32_t component_size; // sizeof component, packed bytes can be smaller for SoA
+        uint32_t records_count;
+        uint32_t flags; // SnapshotPoolHeader::RAW, there are no records without it
+        uint32_t reserved;
+    };
+
+    struct DeltaRecord {
+        entity target;
+        uint32_t bytes; // encoded
+        uint32_t patch; // 1 XOR with existing component, 0 insert
+    };
+
+    // Runs of zero bytes and literal bytes: [zeros count, literals count, literals...], both counts < 256.
+    // Trailing zeros aren't written, so unchanged component is empty. XOR with base keeps small changes short
+    inline void DeltaEncode(std::span<const std::byte> current, const std::byte* base, std::vector<std::byte>& out) {
+        auto byte_at = [&](const size_t position) { return base ? current[position] ^ base[position] : current[position]; };
+        size_t end = current.size();
+        while (end > 0 && byte_at(end - 1) == std::byte{0}) end--;
+
+        size_t position = 0;
+        while (position < end) {
+            size_t zeros = 0;
+            while (position + zeros < end && zeros < 255 && byte_at(position + zeros) == std::byte{0}) zeros++;
+            position += zeros;
+            size_t literals = 0;
+            // single zero inside literals is cheaper than new run
+            while (position + literals < end && literals < 255 && !(byte_at(position + literals) == std::byte{0}
+                && (position + literals + 1 >= end || byte_at(position + literals + 1) == std::byte{0}))) literals++;
+            out.push_back(static_cast<std::byte>(zeros));
+            out.push_back(static_cast<std::byte>(literals));
+            for (size_t i = 0; i < literals; i++) out.push_back(byte_at(position + i));
+            position += literals;
+        }
+    }
+    // writes decoded XOR mask to out, false if encoded bytes don't fit
+    [[nodiscard]] inline bool DeltaDecode(std::span<const std::byte> encoded, std::span<std::byte> out) {
+        std::fill(out.begin(), out.end(), std::byte{0});
+        size_t position = 0;
+        for (size_t offset = 0; offset < encoded.size(); ) {
+            if (encoded.size() - offset < 2) return false;
+            position += static_cast<size_t>(encoded[offset]);
+            const size_t literals = static_cast<size_t>(encoded[offset + 1]);
+            offset += 2;
+            if (literals > encoded.size() - offset || position > out.size() || literals > out.size() - position) return false;
+            std::memcpy(out.data() + position, encoded.data() + offset, literals);
+            position += literals;
+            offset += literals;
+        }
+        return true;
+    }
+
+    // Snapshot Writer
+    // Sequential writes to stream, blocks are padded to SNAPSHOT_ALIGNMENT
+
+    class SnapshotWriter {
+    public:
+        explicit SnapshotWriter(std::ostream& out) : _out{out} { }
+
+        template <typename T>
+        void Write(const T& value) {
+            static_assert(std::is_trivially_copyable_v<T>, "Only trivially copyable values can be written");
+            Write(&value, sizeof(T));
+        }
+        void Write(const void* data, const size_t bytes) {
+            _out.write(static_cast<const char*>(data), static_cast<std::streamsize>(bytes));
+            _offset += bytes;
+        }
+        // bytes of block can be written with several Write, then Align
+        void Block(const void* data, const size_t bytes) {
+            Write(data, bytes);
+            Align();
+        }
+        void Align() {
+            static constexpr char zeros[SNAPSHOT_ALIGNMENT] = {};
+            Write(zeros, SnapshotAligned(_offset) - _offset);
+        }
+
+        [[nodiscard]] size_t GetOffset() const { return _offset; }
+        [[nodiscard]] bool Good() const { return static_cast<bool>(_out); }
+
+    private:
+        std::ostream& _out;
+        size_t _offset = 0;
+    };
+
+    // Snapshot Reader
+    // Bounds checked reads over bytes of snapshot, blocks point into the bytes, nothing is copied
+
+    class SnapshotReader {
+    public:
+        explicit SnapshotReader(std::span<const std::byte> bytes) : _bytes{bytes} { }
+
+        template <typename T>
+        [[nodiscard]] bool Read(T& value) {
+            static_assert(std::is_trivially_copyable_v<T>, "Only trivially copyable values can be read");
+            if (_offset + sizeof(T) > _bytes.size()) return false;
+            std::memcpy(&value, _bytes.data() + _offset, sizeof(T));
+            _offset += sizeof(T);
+            return true;
+        }
+        // aligned block, nullptr if bytes are out of snapshot. Padding after block is skipped as in SnapshotWriter::Block
+        [[nodiscard]] const std::byte* Block(const size_t bytes) {
+            const size_t offset = SnapshotAligned(_offset);
+            if (offset > _bytes.size() || bytes > _bytes.size() - offset) return nullptr;
+            _offset = std::min(SnapshotAligned(offset + bytes), _bytes.size());
+            return _bytes.data() + offset;
+        }
+        [[nodiscard]] bool Skip(const size_t bytes) {
+            if (bytes > _bytes.size() - _offset) return false;
+            _offset += bytes;
+            return true;
+        }
+
+        [[nodiscard]] size_t GetOffset() const { return _offset; }
+        void SetOffset(const size_t offset) { _offset = std::min(offset, _bytes.size()); }
+
+    private:
+        std::span<const std::byte> _bytes;
+        size_t _offset = 0;
+    };
+
+    // Mapped File
+    // Read only mmap of whole file on POSIX, file is read to memory on other platforms or if mmap fails
+
+    class MappedFile {
+    public:
+        explicit MappedFile(const std::string& path) {
+#if YAECS_SNAPSHOT_MMAP
+            const int descriptor = ::open(path.c_str(), O_RDONLY);
+            if (descriptor >= 0) {
+                struct stat status{};
+                if (::fstat(descriptor, &status) == 0 && status.st_size > 0) {
+                    void* mapped = ::mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_PRIVATE, descriptor, 0);
+                    if (mapped != MAP_FAILED) {
+                        _mapped = mapped;
+                        _size = static_cast<size_t>(status.st_size);
+                        ::madvise(mapped, _size, MADV_SEQUENTIAL);
+                    }
+                }
+                ::close(descriptor);
+                if (_mapped) return;
+            }
+#endif
+            std::ifstream file{path, std::ios::binary | std::ios::ate};
+            if (!file) return;
+            _buffer.resize(static_cast<size_t>(file.tellg()));
+            file.seekg(0);
+            file.read(reinterpret_cast<char*>(_buffer.data()), static_cast<std::streamsize>(_buffer.size()));
+            if (!file) _buffer.clear();
+            _size = _buffer.size();
+        }
+        ~MappedFile() {
+#if YAECS_SNAPSHOT_MMAP
+            if (_mapped) ::munmap(_mapped, _size);
+#endif
+        }
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        [[nodiscard]] std::span<const std::byte> GetBytes() const {
+            return {_mapped ? static_cast<const std::byte*>(_mapped) : _buffer.data(), _size};
+        }
+        [[nodiscard]] bool IsMapped() const { return _mapped != nullptr; }
+        [[nodiscard]] bool Good() const { return _size > 0; }
+
+    private:
+        void* _mapped = nullptr;
+        size_t _size = 0;
+        std::vector<std::byte> _buffer{}; // fallback
+    };
+}
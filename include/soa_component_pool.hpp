@@ -0,0 +1,564 @@
+#pragma once
+
+#include "base.hpp"
+#include "component_pool.hpp"
+#include "tag_component_pool.hpp"
+#include "thread_pool.hpp"
+
+#include <array>
+#include <tuple>
+#include <utility>
+#include <vector>
+#include <type_traits>
+#include <cassert>
+#include <cstring>
+#include <algorithm>
+#include <limits>
+#include <numeric>
+#include <span>
+#include <memory_resource>
+
+namespace ecs {
+
+    // SoA traits
+    // Opt-in for aggregate components, every listed member is stored in own array:
+    //     YAECS_SOA(Particle, &Particle::x, &Particle::y, &Particle::z);
+    // Members must describe the whole state of component and be trivially copyable
+
+    template <typename TComponent>
+    struct soa_traits {
+        static constexpr bool enabled = false;
+    };
+    template <typename TComponent>
+    inline constexpr bool is_soa_v = soa_traits<TComponent>::enabled;
+
+    #define YAECS_SOA(Type, ...) \
+        template <> struct ecs::soa_traits<Type> { \
+            static constexpr bool enabled = true; \
+            static constexpr auto members = std::make_tuple(__VA_ARGS__); \
+        }
+
+    namespace detail {
+        template <typename TMember>
+        struct member_traits;
+        template <typename TClass, typename TField>
+        struct member_traits<TField TClass::*> {
+            using class_type = TClass;
+            using field_type = TField;
+        };
+    }
+
+    // SoA Component Pool
+    // Same sparse set as ComponentPool, but every member is stored in own cache aligned array,
+    // so loops over Field<&T::x>() spans auto-vectorize. Components are accessed through proxy
+    // references, which load/store whole component or single field with get<>().
+    // Unlike paged ComponentPool, growth relocates field arrays. Change ticks work as in ComponentPool
+
+    template <typename TComponent>
+    class SoAComponentPool final : public IComponentPool {
+        static_assert(is_soa_v<TComponent>, "Declare component members with YAECS_SOA");
+        static_assert(std::is_default_constructible_v<TComponent>, "Cannot create pool for component which doesn't has default constructor");
+
+        static constexpr auto MEMBERS = soa_traits<TComponent>::members;
+
+    public:
+        static constexpr size_t FIELDS_COUNT = std::tuple_size_v<std::remove_cv_t<decltype(MEMBERS)>>;
+
+        template <size_t I>
+        using field_type = typename detail::member_traits<
+            std::remove_cv_t<std::tuple_element_t<I, std::remove_cv_t<decltype(MEMBERS)>>>>::field_type;
+
+        // index of field in YAECS_SOA list
+        template <auto Member, size_t I = 0>
+        [[nodiscard]] static constexpr size_t FieldIndex() {
+            static_assert(I < FIELDS_COUNT, "Member isn't listed in YAECS_SOA");
+            if constexpr (std::is_same_v<std::remove_cvref_t<decltype(std::get<I>(MEMBERS))>, decltype(Member)>) {
+                if constexpr (std::get<I>(MEMBERS) == Member) return I;
+                else return FieldIndex<Member, I + 1>();
+            }
+            else return FieldIndex<Member, I + 1>();
+        }
+
+        using const_reference = TComponent;
+
+        class reference {
+        public:
+            reference(SoAComponentPool* pool, size_t index) : _pool{pool}, _index{index} {}
+
+            template <size_t I>
+            [[nodiscard]] field_type<I>& get() const { return _pool->template Field<I>()[_index]; }
+            template <auto Member> requires std::is_member_object_pointer_v<decltype(Member)>
+            [[nodiscard]] auto& get() const { return get<FieldIndex<Member>()>(); }
+
+            operator TComponent() const { return _pool->Load(_index); }
+            const reference& operator=(const TComponent& component) const {
+                _pool->Store(_index, component);
+                return *this;
+            }
+            const reference& operator=(const reference& other) const {
+                return *this = static_cast<TComponent>(other);
+            }
+
+        private:
+            SoAComponentPool* _pool;
+            size_t _index;
+        };
+
+        class iterator {
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using difference_type = std::ptrdiff_t;
+            using value_type = TComponent;
+
+            iterator(SoAComponentPool* pool, size_t index) : _pool{pool}, _index{index} {}
+
+            reference operator*() const { return reference{_pool, _index}; }
+
+            iterator& operator++() { // Prefix increment
+                ++_index;
+                return *this;
+            }
+            iterator operator++(int) { // Postfix increment
+                iterator tmp = *this;
+                ++(*this);
+                return tmp;
+            }
+
+            [[nodiscard]] friend bool operator== (const iterator& a, const iterator& b)
+                { return a._index == b._index; };
+            [[nodiscard]] friend bool operator!= (const iterator& a, const iterator& b)
+                { return a._index != b._index; };
+
+        private:
+            SoAComponentPool* _pool;
+            size_t _index;
+        };
+
+        // chunks of parallel iteration start on cache line of every field array and of changed ticks
+        static constexpr size_t PARALLEL_ALIGNMENT = []<size_t... I>(std::index_sequence<I...>) {
+            size_t alignment = CACHE_LINE_SIZE / std::gcd(sizeof(tick), CACHE_LINE_SIZE);
+            ((alignment = std::lcm(alignment, CACHE_LINE_SIZE / std::gcd(sizeof(field_type<I>), CACHE_LINE_SIZE))), ...);
+            return alignment;
+        }(std::make_index_sequence<FIELDS_COUNT>{});
+
+        // members one after another without padding, as in deltas
+        static constexpr size_t PACKED_SIZE = []<size_t... I>(std::index_sequence<I...>) {
+            return (sizeof(field_type<I>) + ...);
+        }(std::make_index_sequence<FIELDS_COUNT>{});
+        static constexpr std::array<size_t, FIELDS_COUNT> PACKED_OFFSETS = []<size_t... I>(std::index_sequence<I...>) {
+            std::array<size_t, FIELDS_COUNT> offsets{};
+            size_t offset = 0;
+            ((offsets[I] = offset, offset += sizeof(field_type<I>)), ...);
+            return offsets;
+        }(std::make_index_sequence<FIELDS_COUNT>{});
+
+    public: // Core
+
+        // Constructors
+        SoAComponentPool(uint32_t reserve_entities = DEFAULT_ENTITIES_CAPACITY,
+            std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+            : _resource{resource}, _sparse{resource}, _dense{resource}, _added{resource}, _changed{resource} {
+            static_assert(TriviallyCopyable(std::make_index_sequence<FIELDS_COUNT>{}), "SoA fields must be trivially copyable");
+            resize(reserve_entities);
+        }
+        ~SoAComponentPool() { Reallocate(0); }
+        // Move
+        SoAComponentPool(SoAComponentPool&& other) noexcept
+            : _resource{other._resource}, _sparse{std::move(other._sparse)}, _dense{std::move(other._dense)},
+            _added{std::move(other._added)}, _changed{std::move(other._changed)},
+            _fields{std::exchange(other._fields, {})}, _capacity{std::exchange(other._capacity, 0)} {
+            SetTick(other.GetTick());
+            other._dense.clear();
+        }
+        // Copy
+        SoAComponentPool(const SoAComponentPool& other)
+            : _resource{other._resource}, _sparse{other._sparse, other._resource}, _dense{other._dense, other._resource},
+            _added{other._added, other._resource}, _changed{other._changed, other._resource} {
+            SetTick(other.GetTick());
+            Reallocate(other._capacity);
+            CopyFields(other, std::make_index_sequence<FIELDS_COUNT>{});
+        }
+        // Pool is bound to its memory resource, as pmr containers
+        SoAComponentPool& operator=(SoAComponentPool&&)      = delete;
+        SoAComponentPool& operator=(const SoAComponentPool&) = delete;
+
+        // reserve memory for active components
+        void reserve(size_t new_capacity) override {
+            _dense.reserve(new_capacity);
+            _added.reserve(new_capacity);
+            _changed.reserve(new_capacity);
+            if (new_capacity > _capacity) Reallocate(new_capacity);
+        }
+        // set range of entities, which can be stored in pool
+        void resize(size_t new_size) override {
+            assert((new_size >= _sparse.size() || std::all_of(_sparse.begin() + new_size, _sparse.end(),
+                [](const uint32_t index) { return index == NULL_INDEX; })) && "Can't erase entities with components");
+            _sparse.resize(new_size, NULL_INDEX);
+        }
+        void shrink_to_fit() override {
+            _dense.shrink_to_fit();
+            _added.shrink_to_fit();
+            _changed.shrink_to_fit();
+            if (_capacity > _dense.size()) Reallocate(_dense.size());
+        }
+
+        void clear() override {
+            std::fill(_sparse.begin(), _sparse.end(), NULL_INDEX);
+            _dense.clear();
+            _added.clear();
+            _changed.clear();
+        }
+        void reset() override {
+            clear();
+            shrink_to_fit();
+        }
+
+        void InsertComponent(const entity entity, const TComponent& component) {
+            assert(GetEntityIndex(entity) < _sparse.size() && "Entity out of range");
+            uint32_t& index = _sparse[GetEntityIndex(entity)];
+            if (index != NULL_INDEX) {
+                assert(_dense[index] == entity && "Component belongs to other version of entity");
+                Store(index, component);
+                _changed[index] = GetTick();
+                return;
+            }
+            if (_dense.size() == _capacity) Reallocate(std::max<size_t>(_capacity * 2, 8));
+            index = static_cast<uint32_t>(_dense.size());
+            _dense.push_back(entity);
+            _added.push_back(GetTick());
+            _changed.push_back(GetTick());
+            Store(index, component);
+        }
+        void InsertComponents(std::span<const entity> entities, std::span<const TComponent> components) {
+            assert(entities.size() == components.size() && "Count of entities and components must be equal");
+            Grow(entities.size());
+            for (size_t i = 0; i < entities.size(); i++)
+                InsertComponent(entities[i], components[i]);
+        }
+        void InsertComponents(std::span<const entity> entities, const TComponent& component) {
+            Grow(entities.size());
+            for (auto entity : entities)
+                InsertComponent(entity, component);
+        }
+        void RemoveComponent(const entity entity) override {
+            assert(ContainsComponent(entity) && "Entity doesn't have that component");
+
+            uint32_t index = _sparse[GetEntityIndex(entity)];
+            uint32_t last = static_cast<uint32_t>(_dense.size() - 1);
+            if (index != last) { // move last into the hole
+                ecs::entity moved = _dense[last];
+                _dense[index] = moved;
+                MoveFields(last, index, std::make_index_sequence<FIELDS_COUNT>{});
+                _added[index] = _added[last];
+                _changed[index] = _changed[last];
+                _sparse[GetEntityIndex(moved)] = index;
+            }
+            _dense.pop_back();
+            _added.pop_back();
+            _changed.pop_back();
+            _sparse[GetEntityIndex(entity)] = NULL_INDEX;
+        }
+        [[nodiscard]] bool ContainsComponent(const entity entity) const override {
+            const entity_index index = GetEntityIndex(entity);
+            return index < _sparse.size() && _sparse[index] != NULL_INDEX && _dense[_sparse[index]] == entity;
+        }
+        // mutable access, stamps changed tick
+        reference GetComponent(const entity entity) {
+            assert(ContainsComponent(entity) && "Entity doesn't have that component");
+            const uint32_t index = _sparse[GetEntityIndex(entity)];
+            _changed[index] = GetTick();
+            return reference{this, index};
+        }
+
+        // read only access, doesn't stamp changed tick
+        [[nodiscard]] TComponent operator[](const entity entity) const {
+            assert(ContainsComponent(entity) && "Entity doesn't have that component");
+            return Load(_sparse[GetEntityIndex(entity)]);
+        }
+
+        // component was added/changed after since tick
+        [[nodiscard]] bool IsAdded(const entity entity, const tick since) const {
+            assert(ContainsComponent(entity) && "Entity doesn't have that component");
+            return _added[_sparse[GetEntityIndex(entity)]] > since;
+        }
+        [[nodiscard]] bool IsChanged(const entity entity, const tick since) const {
+            assert(ContainsComponent(entity) && "Entity doesn't have that component");
+            return _changed[_sparse[GetEntityIndex(entity)]] > since;
+        }
+        // for writes, which bypass GetComponent (Field spans)
+        void MarkChanged(const entity entity) {
+            assert(ContainsComponent(entity) && "Entity doesn't have that component");
+            _changed[_sparse[GetEntityIndex(entity)]] = GetTick();
+        }
+        // marks all components changed, after loops over Field spans
+        void MarkAllChanged() { std::fill(_changed.begin(), _changed.end(), GetTick()); }
+
+        // dense index access, valid in [0, size())
+        [[nodiscard]] size_t GetIndex(const entity entity) const override {
+            assert(ContainsComponent(entity) && "Entity doesn't have that component");
+            return _sparse[GetEntityIndex(entity)];
+        }
+        [[nodiscard]] entity GetEntityAt(const size_t index) const {
+            assert(index < _dense.size() && "Index out of range");
+            return _dense[index];
+        }
+        [[nodiscard]] reference GetComponentAt(const size_t index) {
+            assert(index < _dense.size() && "Index out of range");
+            _changed[index] = GetTick();
+            return reference{this, index};
+        }
+        [[nodiscard]] TComponent GetComponentAt(const size_t index) const {
+            assert(index < _dense.size() && "Index out of range");
+            return Load(index);
+        }
+        [[nodiscard]] tick GetAddedTickAt(const size_t index) const { return _added[index]; }
+        [[nodiscard]] tick GetChangedTickAt(const size_t index) const { return _changed[index]; }
+        void SwapIndexes(const size_t index1, const size_t index2) override {
+            assert(index1 < _dense.size() && index2 < _dense.size() && "Index out of range");
+            if (index1 == index2) return;
+            std::swap(_dense[index1], _dense[index2]);
+            SwapFields(index1, index2, std::make_index_sequence<FIELDS_COUNT>{});
+            std::swap(_added[index1], _added[index2]);
+            std::swap(_changed[index1], _changed[index2]);
+            _sparse[GetEntityIndex(_dense[index1])] = static_cast<uint32_t>(index1);
+            _sparse[GetEntityIndex(_dense[index2])] = static_cast<uint32_t>(index2);
+        }
+
+        // as ComponentPool::Sort, components are loaded for every comparison
+        template <typename Compare>
+        void Sort(Compare compare, const SortAlgorithm algorithm = SortAlgorithm::Full) {
+            SortIndexes(0, size(), PoolLess(*this, compare), [this](const size_t a, const size_t b) { SwapIndexes(a, b); }, algorithm);
+        }
+
+        // packed values of one member, in the same order as begin_ent_active.
+        // Raw access, writes must be reported with MarkChanged/MarkAllChanged
+        template <size_t I>
+        [[nodiscard]] std::span<field_type<I>> Field() {
+            return {static_cast<field_type<I>*>(_fields[I]), _dense.size()};
+        }
+        template <auto Member> requires std::is_member_object_pointer_v<decltype(Member)>
+        [[nodiscard]] auto Field() { return Field<FieldIndex<Member>()>(); }
+
+        // func(reference) or func(entity, reference) for every component, stamps changed tick of every component
+        template <typename Func>
+        void ParallelForEach(Func func, const size_t grain = DEFAULT_PARALLEL_GRAIN,
+            ThreadPool& thread_pool = ThreadPool::Shared()) {
+            auto chunk = [this, &func](const size_t begin, const size_t end) {
+                std::fill(_changed.begin() + begin, _changed.begin() + end, GetTick());
+                for (size_t index = begin; index < end; index++) {
+                    if constexpr (std::is_invocable_v<Func, entity, reference>)
+                        func(_dense[index], reference{this, index});
+                    else
+                        func(reference{this, index});
+                }
+            };
+            thread_pool.ParallelChunks(_dense.size(), grain, PARALLEL_ALIGNMENT, chunk);
+        }
+
+        [[nodiscard]] size_t size() const override { return _dense.size(); }
+        [[nodiscard]] const entity* data() const override { return _dense.data(); }
+        [[nodiscard]] size_t capacity() const { return _capacity; }
+        [[nodiscard]] PoolStats MemoryStats() const override {
+            PoolStats stats{};
+            stats.count = _dense.size();
+            stats.capacity = _capacity;
+            stats.sparse_bytes = _sparse.capacity() * sizeof(uint32_t);
+            stats.used_bytes = _sparse.size() * sizeof(uint32_t)
+                + _dense.size() * (sizeof(entity) + 2 * sizeof(tick) + PACKED_SIZE);
+            stats.reserved_bytes = stats.sparse_bytes + (_dense.capacity() * sizeof(entity))
+                + (_added.capacity() + _changed.capacity()) * sizeof(tick) + _capacity * PACKED_SIZE;
+            return stats;
+        }
+        [[nodiscard]] std::pmr::memory_resource* GetResource() const { return _resource; }
+
+    public: // Snapshot
+
+        // components are written as one block per member, fields are always trivially copyable
+        [[nodiscard]] SnapshotPoolHeader GetSnapshotHeader() const override {
+            return SnapshotPoolHeader{SnapshotTypeHash<TComponent>(), 0, sizeof(TComponent), 
+                static_cast<uint32_t>(_dense.size()), SnapshotPoolHeader::RAW, 0};
+        }
+        void SaveSnapshot(SnapshotWriter& writer) const override {
+            const size_t count = _dense.size();
+            SnapshotPoolHeader header = GetSnapshotHeader();
+            header.payload_bytes = GetSnapshotPayloadBytes(count);
+            writer.Write(header);
+            writer.Align();
+            writer.Block(_dense.data(), count * sizeof(entity));
+            writer.Block(_added.data(), count * sizeof(tick));
+            writer.Block(_changed.data(), count * sizeof(tick));
+            [&]<size_t... I>(std::index_sequence<I...>) {
+                (writer.Block(_fields[I], count * sizeof(field_type<I>)), ...);
+            }(std::make_index_sequence<FIELDS_COUNT>{});
+        }
+        [[nodiscard]] bool CanLoadSnapshot(const SnapshotPoolHeader& header) const override {
+            return header.type_hash == SnapshotTypeHash<TComponent>() && header.component_size == sizeof(TComponent)
+                && (header.flags & SnapshotPoolHeader::RAW);
+        }
+        [[nodiscard]] size_t GetSnapshotPayloadBytes(const size_t count) const override {
+            return SnapshotAligned(count * sizeof(entity)) + 2 * SnapshotAligned(count * sizeof(tick))
+                + [count]<size_t... I>(std::index_sequence<I...>) {
+                    return (SnapshotAligned(count * sizeof(field_type<I>)) + ...);
+                }(std::make_index_sequence<FIELDS_COUNT>{});
+        }
+        // one bulk copy per array and member
+        void LoadSnapshot(const SnapshotPoolHeader& header, SnapshotReader& reader) override {
+            clear();
+            const size_t count = header.count;
+            const std::byte* entities = reader.Block(count * sizeof(entity));
+            const std::byte* added = reader.Block(count * sizeof(tick));
+            const std::byte* changed = reader.Block(count * sizeof(tick));
+            assert(entities && added && changed && "Snapshot payload is out of range");
+
+            reserve(count);
+            _dense.resize(count);
+            _added.resize(count);
+            _changed.resize(count);
+            if (count == 0) return;
+            std::memcpy(_dense.data(), entities, count * sizeof(entity));
+            std::memcpy(_added.data(), added, count * sizeof(tick));
+            std::memcpy(_changed.data(), changed, count * sizeof(tick));
+            [&]<size_t... I>(std::index_sequence<I...>) {
+                (LoadField<I>(reader, count), ...);
+            }(std::make_index_sequence<FIELDS_COUNT>{});
+            for (size_t index = 0; index < count; index++) {
+                assert(GetEntityIndex(_dense[index]) < _sparse.size() && "Entity out of range");
+                _sparse[GetEntityIndex(_dense[index])] = static_cast<uint32_t>(index);
+            }
+        }
+
+    public: // Deltas
+
+        [[nodiscard]] bool IsTriviallyCopyable() const override { return true; }
+        [[nodiscard]] size_t GetPackedSize() const override { return PACKED_SIZE; }
+        [[nodiscard]] std::span<const tick> GetChangedTicks() const override { return _changed; }
+        void ReadPacked(const size_t index, std::byte* out) const override {
+            assert(index < _dense.size() && "Index out of range");
+            [&]<size_t... I>(std::index_sequence<I...>) {
+                (std::memcpy(out + PACKED_OFFSETS[I], static_cast<const field_type<I>*>(_fields[I]) + index, sizeof(field_type<I>)), ...);
+            }(std::make_index_sequence<FIELDS_COUNT>{});
+        }
+        void ReadSnapshotPacked(const std::byte* payload, const size_t count, const size_t index, std::byte* out) const override {
+            size_t field = SnapshotAligned(count * sizeof(entity)) + 2 * SnapshotAligned(count * sizeof(tick));
+            [&]<size_t... I>(std::index_sequence<I...>) {
+                ((std::memcpy(out + PACKED_OFFSETS[I], payload + field + index * sizeof(field_type<I>), sizeof(field_type<I>)),
+                    field += SnapshotAligned(count * sizeof(field_type<I>))), ...);
+            }(std::make_index_sequence<FIELDS_COUNT>{});
+        }
+        void ApplyPacked(const entity entity, const std::byte* mask, const bool patch) override {
+            if (!patch) {
+                TComponent component{};
+                [&]<size_t... I>(std::index_sequence<I...>) {
+                    (std::memcpy(&(component.*std::get<I>(MEMBERS)), mask + PACKED_OFFSETS[I], sizeof(field_type<I>)), ...);
+                }(std::make_index_sequence<FIELDS_COUNT>{});
+                InsertComponent(entity, component);
+                return;
+            }
+            assert(ContainsComponent(entity) && "Entity doesn't have that component");
+            const uint32_t index = _sparse[GetEntityIndex(entity)];
+            _changed[index] = GetTick();
+            [&]<size_t... I>(std::index_sequence<I...>) {
+                (XorField<I>(index, mask + PACKED_OFFSETS[I]), ...);
+            }(std::make_index_sequence<FIELDS_COUNT>{});
+        }
+
+    public: // Iterators
+
+        // iterate packed components, order is the same as in begin_ent_active
+        [[nodiscard]] iterator begin_comp_active() { return iterator{this, 0}; }
+        [[nodiscard]] iterator end_comp_active() { return iterator{this, _dense.size()}; }
+
+        // iterate packed entities, which have component
+        [[nodiscard]] auto begin_ent_active() const { return _dense.cbegin(); }
+        [[nodiscard]] auto end_ent_active() const { return _dense.cend(); }
+
+    private:
+        template <size_t... I>
+        static constexpr bool TriviallyCopyable(std::index_sequence<I...>) {
+            return (std::is_trivially_copyable_v<field_type<I>> && ...);
+        }
+        template <size_t I>
+        static constexpr size_t FieldAlignment() {
+            return std::max(alignof(field_type<I>), CACHE_LINE_SIZE);
+        }
+
+        [[nodiscard]] TComponent Load(const size_t index) const {
+            TComponent component{};
+            [&]<size_t... I>(std::index_sequence<I...>) {
+                ((component.*std::get<I>(MEMBERS) = static_cast<const field_type<I>*>(_fields[I])[index]), ...);
+            }(std::make_index_sequence<FIELDS_COUNT>{});
+            return component;
+        }
+        void Store(const size_t index, const TComponent& component) {
+            [&]<size_t... I>(std::index_sequence<I...>) {
+                ((static_cast<field_type<I>*>(_fields[I])[index] = component.*std::get<I>(MEMBERS)), ...);
+            }(std::make_index_sequence<FIELDS_COUNT>{});
+        }
+
+        template <size_t... I>
+        void MoveFields(const size_t from, const size_t to, std::index_sequence<I...>) {
+            ((static_cast<field_type<I>*>(_fields[I])[to] = static_cast<field_type<I>*>(_fields[I])[from]), ...);
+        }
+        template <size_t... I>
+        void SwapFields(const size_t index1, const size_t index2, std::index_sequence<I...>) {
+            (std::swap(static_cast<field_type<I>*>(_fields[I])[index1], static_cast<field_type<I>*>(_fields[I])[index2]), ...);
+        }
+        template <size_t... I>
+        void CopyFields(const SoAComponentPool& other, std::index_sequence<I...>) {
+            ((other._dense.empty() ? void() : void(std::memcpy(_fields[I], other._fields[I], other._dense.size() * sizeof(field_type<I>)))), ...);
+        }
+
+        template <size_t I>
+        void XorField(const size_t index, const std::byte* mask) {
+            std::byte* bytes = reinterpret_cast<std::byte*>(static_cast<field_type<I>*>(_fields[I]) + index);
+            for (size_t i = 0; i < sizeof(field_type<I>); i++) bytes[i] ^= mask[i];
+        }
+        template <size_t I>
+        void LoadField(SnapshotReader& reader, const size_t count) {
+            const std::byte* field = reader.Block(count * sizeof(field_type<I>));
+            assert(field && "Snapshot payload is out of range");
+            std::memcpy(_fields[I], field, count * sizeof(field_type<I>));
+        }
+
+        // moves active fields to arrays of new_capacity, 0 releases arrays
+        void Reallocate(const size_t new_capacity) {
+            [&]<size_t... I>(std::index_sequence<I...>) {
+                (ReallocateField<I>(new_capacity), ...);
+            }(std::make_index_sequence<FIELDS_COUNT>{});
+            _capacity = new_capacity;
+        }
+        template <size_t I>
+        void ReallocateField(const size_t new_capacity) {
+            void* field = nullptr;
+            if (new_capacity > 0) {
+                field = _resource->allocate(new_capacity * sizeof(field_type<I>), FieldAlignment<I>());
+                if (_fields[I] && !_dense.empty()) std::memcpy(field, _fields[I], std::min(_dense.size(), new_capacity) * sizeof(field_type<I>));
+            }
+            if (_fields[I]) _resource->deallocate(_fields[I], _capacity * sizeof(field_type<I>), FieldAlignment<I>());
+            _fields[I] = field;
+        }
+
+        // reserve for count more components, keeps geometric growth for repeated batches
+        void Grow(const size_t count) {
+            const size_t required = _dense.size() + count;
+            if (required > _capacity)
+                reserve(std::max(required, _capacity * 2));
+        }
+
+        static constexpr uint32_t NULL_INDEX = std::numeric_limits<uint32_t>::max();
+
+        std::pmr::memory_resource* _resource;
+        std::pmr::vector<uint32_t> _sparse;
+        std::pmr::vector<entity> _dense;
+        std::pmr::vector<tick> _added; // tick of insert, packed as _dense
+        std::pmr::vector<tick> _changed; // tick of last mutable access, packed as _dense
+        std::array<void*, FIELDS_COUNT> _fields{}; // array of field_type<I> per member
+        size_t _capacity = 0;
+    };
+
+    // Pool type for component: SoA for components declared with YAECS_SOA, membership only for empty tags,
+    // paged otherwise
+    template <typename TComponent>
+    using pool_for = std::conditional_t<is_soa_v<TComponent>, SoAComponentPool<TComponent>,
+        std::conditional_t<is_tag_v<TComponent>, TagComponentPool<TComponent>, ComponentPool<TComponent>>>;
+}
@@ -0,0 +1,236 @@
+#pragma once
+
+#include "signature.hpp"
+
+#include "base.hpp"
+#include "types.hpp"
+#include "component_pool.hpp"
+#include "soa_component_pool.hpp"
+#include "view.hpp"
+#include "group.hpp"
+
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <memory>
+#include <memory_resource>
+#include <span>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace ecs {
+
+    // index of T in Ts..., compile error if T isn't there
+    template <typename TComponent, typename... TComponents>
+    constexpr size_t component_index_v = []() {
+        constexpr bool matches[] = {std::is_same_v<TComponent, TComponents>...};
+        size_t index = 0;
+        while (index < sizeof...(TComponents) && !matches[index]) index++;
+        return index;
+    }();
+
+    // Static World
+    // World with component set fixed at compile time: component index is constexpr, signature mask of view
+    // is a constant and pools are held by value in tuple, so every access is a direct call of final pool
+    // without hashing, shared_ptr or virtual dispatch. Entities and free list work as in World.
+    // Views and groups are the same classes as in World
+
+    template <typename... TComponents>
+    class StaticWorld {
+        static_assert(sizeof...(TComponents) > 0, "StaticWorld requires at least one component");
+        static_assert(sizeof...(TComponents) <= signature::CAPACITY, "Signature is too small, increase YAECS_SIGNATURE_WORDS");
+
+        template <typename TComponent>
+        static constexpr bool HAS_COMPONENT = (std::is_same_v<TComponent, TComponents> || ...);
+
+    public:
+        static constexpr size_t COMPONENTS_COUNT = sizeof...(TComponents);
+
+        template <typename TComponent>
+        static constexpr size_t INDEX = component_index_v<std::remove_const_t<TComponent>, TComponents...>;
+
+        // resource is used by signatures, entities and all component pools of world
+        explicit StaticWorld(uint32_t entities_capacity = DEFAULT_ENTITIES_CAPACITY,
+            std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+            : _resource{resource}, _signatures{entities_capacity, resource}, _entities{resource},
+            _pools{pool_for<TComponents>(entities_capacity, resource)...}, _entities_capacity{entities_capacity} {
+            std::apply([this](auto&... pools) { (pools.SetTick(GetTick()), ...); }, _pools);
+        }
+
+        StaticWorld(const StaticWorld&) = delete;
+        StaticWorld& operator=(const StaticWorld&) = delete;
+
+    private:
+        #define assert_static_created_entity(entity) assert(ExistsEntity(entity) && "Entity doesn't created or already destroyed");
+
+    public: // Entities
+
+        [[nodiscard]] entity CreateEntity() {
+            _entities_count++;
+
+            if (_free_entity == NULL_ENTITY_INDEX) {
+                assert(_entities.size() < _entities_capacity && "Doesn't have available entities, do expand entities capacity");
+                entity_index index = static_cast<entity_index>(_entities.size());
+                return _entities.emplace_back(MakeEntity(index, 0));
+            }
+
+            entity_index index = _free_entity;
+            entity& slot = _entities[index];
+            _free_entity = GetEntityIndex(slot);
+            slot = MakeEntity(index, GetEntityVersion(slot));
+            return slot;
+        }
+        void CreateEntities(const size_t count, std::span<entity> out) {
+            assert(out.size() >= count && "Output span is too small");
+            for (size_t i = 0; i < count; i++) out[i] = CreateEntity();
+        }
+
+        void DestroyEntity(const entity entity) {
+            assert_static_created_entity(entity);
+            RemoveAllComponents(entity);
+
+            entity_index index = GetEntityIndex(entity);
+            _entities[index] = MakeEntity(_free_entity, GetEntityVersion(entity) + 1);
+            _free_entity = index;
+            _entities_count--;
+        }
+
+        [[nodiscard]] bool ExistsEntity(const entity entity) const {
+            entity_index index = GetEntityIndex(entity);
+            return index < _entities.size() && _entities[index] == entity;
+        }
+        [[nodiscard]] uint32_t GetEntitiesCount() const { return _entities_count; }
+        [[nodiscard]] const signature& GetSignature(const entity entity) const {
+            assert_static_created_entity(entity);
+            return _signatures[GetEntityIndex(entity)];
+        }
+
+    public: // Components
+
+        template <typename TComponent>
+        void AddComponent(const entity entity, TComponent component) {
+            assert(!ContainsComponent<TComponent>(entity) && "Already contains this component in this entity");
+            InsertComponent(entity, std::move(component));
+        }
+        template <typename TComponent>
+        void InsertComponent(const entity entity, TComponent component) {
+            assert_static_created_entity(entity);
+            GetPool<TComponent>().InsertComponent(entity, std::move(component));
+            _signatures[GetEntityIndex(entity)].set(INDEX<TComponent>);
+            if (auto group = _component_groups[INDEX<TComponent>]) group->OnInsert(entity);
+        }
+        // inserts copy of component to every entity
+        template <typename TComponent>
+        void InsertComponents(std::span<const entity> entities, const TComponent& component) {
+            auto& pool = GetPool<TComponent>();
+            pool.InsertComponents(entities, component);
+            for (auto entity : entities) {
+                assert_static_created_entity(entity);
+                _signatures[GetEntityIndex(entity)].set(INDEX<TComponent>);
+            }
+            if (auto group = _component_groups[INDEX<TComponent>])
+                for (auto entity : entities) group->OnInsert(entity);
+        }
+
+        template <typename TComponent>
+        void RemoveComponent(const entity entity) {
+            assert_static_created_entity(entity);
+            if (auto group = _component_groups[INDEX<TComponent>]) group->OnRemove(entity);
+            GetPool<TComponent>().RemoveComponent(entity);
+            _signatures[GetEntityIndex(entity)].set(INDEX<TComponent>, false);
+        }
+        void RemoveAllComponents(const entity entity) {
+            const signature& signature = GetSignature(entity);
+            // component set is known, so removal is unrolled over pools instead of scanning bits
+            [&]<size_t... I>(std::index_sequence<I...>) {
+                ((signature.get(I) ? RemoveComponent<TComponents>(entity) : void()), ...);
+            }(std::index_sequence_for<TComponents...>{});
+        }
+
+        // TComponent& or proxy reference for SoA components, stamps changed tick.
+        // GetComponent<const TComponent> is read only access, which doesn't stamp
+        template <typename TComponent>
+        [[nodiscard]] decltype(auto) GetComponent(const entity entity) {
+            auto& pool = GetPool<std::remove_const_t<TComponent>>();
+            if constexpr (std::is_const_v<TComponent>) return std::as_const(pool)[entity];
+            else return pool.GetComponent(entity);
+        }
+        template <typename TComponent>
+        [[nodiscard]] bool ContainsComponent(const entity entity) const {
+            assert_static_created_entity(entity);
+            return _signatures[GetEntityIndex(entity)].get(INDEX<TComponent>);
+        }
+
+    public: // Views and Groups
+
+        // mask of view is computed at compile time
+        template <typename... TQueries>
+        [[nodiscard]] ecs::View<TQueries...> View(const tick since = 0) {
+            static constexpr signature mask = []() {
+                signature result{};
+                (result.set(INDEX<query_component_t<TQueries>>), ...);
+                return result;
+            }();
+            return ecs::View<TQueries...>{_signatures.data(), mask, &GetPool<query_component_t<TQueries>>()..., since};
+        }
+
+        // Persistent owning group, as World::Group
+        template <typename... TGroupComponents>
+        [[nodiscard]] ecs::Group<TGroupComponents...>& Group() {
+            type_index group_type = TypeIndexator<ecs::Group<TGroupComponents...>>::value();
+            auto found = _groups.find(group_type);
+            if (found != _groups.end())
+                return *static_cast<ecs::Group<TGroupComponents...>*>(found->second.get());
+
+            assert(((_component_groups[INDEX<TGroupComponents>] == nullptr) && ...) && "Component already owned by other group");
+            auto group = std::make_unique<ecs::Group<TGroupComponents...>>(&GetPool<TGroupComponents>()...);
+            auto& result = *group;
+            ((_component_groups[INDEX<TGroupComponents>] = group.get()), ...);
+            _groups.insert_or_assign(group_type, std::move(group));
+            return result;
+        }
+
+    public: // Pools
+
+        template <typename TComponent>
+        [[nodiscard]] pool_for<TComponent>& GetPool() {
+            static_assert(HAS_COMPONENT<TComponent>, "Component isn't part of StaticWorld");
+            return std::get<INDEX<TComponent>>(_pools);
+        }
+        template <typename TComponent>
+        [[nodiscard]] const pool_for<TComponent>& GetPool() const {
+            static_assert(HAS_COMPONENT<TComponent>, "Component isn't part of StaticWorld");
+            return std::get<INDEX<TComponent>>(_pools);
+        }
+        [[nodiscard]] std::pmr::memory_resource* GetResource() const { return _resource; }
+
+    public: // Ticks
+
+        [[nodiscard]] tick GetTick() const { return _tick.load(std::memory_order_relaxed); }
+        // components inserted/changed after advance are stamped with new tick, returns new tick
+        tick AdvanceTick() {
+            const tick tick = _tick.fetch_add(1, std::memory_order_relaxed) + 1;
+            std::apply([tick](auto&... pools) { (pools.SetTick(tick), ...); }, _pools);
+            return tick;
+        }
+
+    private:
+        #undef assert_static_created_entity
+
+        std::pmr::memory_resource* _resource;
+        std::atomic<tick> _tick{1}; // tick 0 is before everything
+        std::pmr::vector<signature> _signatures; // signature matrix, indexed by entity index
+        std::pmr::vector<entity> _entities; // alive entities and implicit free list
+        entity_index _free_entity = NULL_ENTITY_INDEX; // head of free list
+        uint32_t _entities_count = 0;
+
+        std::tuple<pool_for<TComponents>...> _pools;
+        uint32_t _entities_capacity;
+
+        std::array<IGroup*, sizeof...(TComponents)> _component_groups{}; // owner group by component index
+        std::unordered_map<type_index, std::unique_ptr<IGroup>> _groups;
+    };
+}
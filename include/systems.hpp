@@ -1,6 +1,8 @@
 #pragma once
 
 #include "world.hpp"
+#include "thread_pool.hpp"
+#include "profiler.hpp"
 
 #include <atomic>
 #include <vector>
@@ -9,28 +11,106 @@
 #include <queue>
 #include <bitset>
 #include <set>
+#include <algorithm>
+#include <utility>
 
 namespace ecs {
 
     class Systems;
 
+    // System Access
+    // Component types which system reads and writes, systems without conflicts run concurrently.
+    // Access of system without declaration is exclusive, it conflicts with any other system
+
+    template <typename... TComponents>
+    struct Read {};
+    template <typename... TComponents>
+    struct Write {};
+
+    class SystemAccess {
+    public:
+        template <typename... TComponents>
+        void AddRead() { (Insert(_reads, TypeIndexator<TComponents>::value()), ...); _exclusive = false; }
+        template <typename... TComponents>
+        void AddWrite() { (Insert(_writes, TypeIndexator<TComponents>::value()), ...); _exclusive = false; }
+
+        template <typename... TComponents>
+        void Add(Read<TComponents...>) { AddRead<TComponents...>(); }
+        template <typename... TComponents>
+        void Add(Write<TComponents...>) { AddWrite<TComponents...>(); }
+
+        [[nodiscard]] bool IsExclusive() const { return _exclusive; }
+        [[nodiscard]] bool Conflicts(const SystemAccess& other) const {
+            if (_exclusive || other._exclusive) return true;
+            return Intersects(_writes, other._writes) 
+                || Intersects(_writes, other._reads) 
+                || Intersects(_reads, other._writes);
+        }
+
+    private:
+        static void Insert(std::vector<type_index>& types, const type_index type) {
+            if (std::find(types.begin(), types.end(), type) == types.end()) types.push_back(type);
+        }
+        [[nodiscard]] static bool Intersects(const std::vector<type_index>& a, const std::vector<type_index>& b) {
+            for (auto type : a)
+                if (std::find(b.begin(), b.end(), type) != b.end()) return true;
+            return false;
+        }
+
+        std::vector<type_index> _reads{};
+        std::vector<type_index> _writes{};
+        bool _exclusive = true;
+    };
+
+    class ISystem;
+    template <typename TSystem> requires std::derived_from<TSystem, ISystem>
+    class SystemCollection;
+
     // Base System
 
     class System {
     public:
         virtual ~System() = default;
         World& world() { return *world_; }
+        [[nodiscard]] const SystemAccess& access() const { return _access; }
+        // deferred structural changes, flushed after system collection execution
+        CommandBuffer& commands() { return _commands; }
+        // world tick at the end of previous run, 0 before first run.
+        // world().View<Changed<T>>(last_run_tick()) passes changes made since previous run
+        [[nodiscard]] tick last_run_tick() const { return _last_run_tick; }
+#if YAECS_PROFILE
+        [[nodiscard]] const SystemProfile& profile() const { return _profile; }
+#endif
         
+    protected:
+        // entities processed by current run, reported to profiler, no-op without YAECS_PROFILE
+        void AddProcessed([[maybe_unused]] const size_t count) {
+#if YAECS_PROFILE
+            _processed += count;
+#endif
+        }
+
+        SystemAccess _access{};
+        CommandBuffer _commands{};
+
     private:
-        std::unique_ptr<World> world_;
+        World* world_ = nullptr;
+        tick _last_run_tick = 0;
+#if YAECS_PROFILE
+        SystemProfile _profile{};
+        uint64_t _processed = 0;
+#endif
 
         friend Systems;
+        template <typename TSystem> requires std::derived_from<TSystem, ISystem>
+        friend class SystemCollection;
     };
 
     // Default System Interfaces (you can add yours)
 
     class ISystem {
     public:
+        virtual ~ISystem() = default;
         virtual void execute() = 0;
     };
 
@@ -52,6 +132,11 @@ namespace ecs {
         virtual void destroy() = 0;
     };
 
+    // System Collection
+    // Executes systems as dependency graph on thread pool: system depends on every system
+    // added before it with conflicting access, so conflicting systems keep insertion order
+    // and the others run concurrently. Without thread pool systems run in insertion order
+
     template <typename TSystem> requires std::derived_from<TSystem, ISystem>
     class SystemCollection : public ISystem {
     public:
@@ -59,32 +144,159 @@ namespace ecs {
         ~SystemCollection() = default;
 
         void execute() override {
-            for (auto it = systems.begin(); it != systems.end(); ++it) {
-                auto& ptr = *it;
-                ptr->execute();
+            if (systems.empty()) return;
+            if (_dirty) BuildGraph();
+#if YAECS_PROFILE
+            const uint64_t begin = Profiler::Shared().Now();
+#endif
+
+            if (_thread_pool == nullptr || _thread_pool->GetThreadsCount() == 1 || systems.size() == 1) {
+                for (size_t index = 0; index < systems.size(); index++) Run(index);
+            } else {
+                ExecuteGraph();
             }
+            FlushCommands();
+#if YAECS_PROFILE
+            Profiler::Shared().Record(Profiler::Event{_name, "collection", begin, Profiler::Shared().Now(), 0});
+#endif
         }
 
         void AddSystem(std::shared_ptr<TSystem> system) {
-            systems.insert(system);
+            assert(std::find(systems.begin(), systems.end(), system) == systems.end() && "System already added");
+            systems.push_back(system);
+            _dirty = true;
         }
         void RemoveSystem(std::shared_ptr<TSystem> system) {
-            systems.erase(system);
+            auto found = std::find(systems.begin(), systems.end(), system);
+            if (found == systems.end()) return;
+            systems.erase(found);
+            _dirty = true;
         }
         void Clear() {
             systems.clear();
+            _dirty = true;
         }
 
+        // nullptr to run systems sequentially
+        void SetThreadPool(ThreadPool* thread_pool) { _thread_pool = thread_pool; }
+
     private:
-        // it uses ptr as hashable obj while system now is non const
-        std::unordered_set<std::shared_ptr<ISystem>> systems{};
+        struct Node {
+            std::vector<size_t> dependents{};
+            size_t dependencies = 0;
+            std::atomic<size_t> remaining{0};
+        };
+
+        void BuildGraph() {
+            std::vector<SystemAccess> accesses(systems.size());
+            _bases.assign(systems.size(), nullptr);
+            for (size_t index = 0; index < systems.size(); index++) {
+                // ISystem is not related to System, ask most derived object
+                _bases[index] = dynamic_cast<System*>(systems[index].get());
+                if (_bases[index]) accesses[index] = _bases[index]->access();
+            }
+#if YAECS_PROFILE
+            _name = Profiler::Shared().Intern(Profiler::TypeName(typeid(SystemCollection)));
+            _names.resize(systems.size());
+            for (size_t index = 0; index < systems.size(); index++)
+                _names[index] = Profiler::Shared().Intern(Profiler::TypeName(typeid(*systems[index])));
+#endif
+
+            _nodes = std::make_unique<Node[]>(systems.size());
+            for (size_t index = 0; index < systems.size(); index++) {
+                for (size_t before = 0; before < index; before++) {
+                    if (!accesses[index].Conflicts(accesses[before])) continue;
+                    _nodes[before].dependents.push_back(index);
+                    _nodes[index].dependencies++;
+                }
+            }
+            _dirty = false;
+        }
+
+        // sync point, commands of all systems are applied in one batch, then observers are notified
+        void FlushCommands() {
+            _buffers.clear();
+            World* world = nullptr;
+            for (auto system : _bases) {
+                if (system == nullptr || system->world_ == nullptr) continue;
+                world = system->world_;
+                if (!system->commands().empty()) _buffers.push_back(&system->commands());
+            }
+#if YAECS_PROFILE
+            const uint64_t begin = Profiler::Shared().Now();
+#endif
+            if (world) world->Flush(_buffers); // delivers observer events too
+#if YAECS_PROFILE
+            Profiler::Shared().Record(Profiler::Event{"Flush", "flush", begin, Profiler::Shared().Now(), _buffers.size()});
+#endif
+        }
+
+        void ExecuteGraph() {
+            for (size_t index = 0; index < systems.size(); index++)
+                _nodes[index].remaining.store(_nodes[index].dependencies, std::memory_order_relaxed);
+
+            std::atomic<size_t> counter{systems.size()};
+            _counter = &counter;
+            for (size_t index = 0; index < systems.size(); index++) {
+                if (_nodes[index].dependencies == 0)
+                    _thread_pool->Submit(ThreadPool::Task{&ExecuteNode, this, index, _counter});
+            }
+            _thread_pool->Wait(counter);
+            _counter = nullptr;
+        }
+
+        // changes made by system are stamped with ticks <= its last run tick,
+        // changes made after it finished (by dependent systems too) get greater ticks
+        void Run(const size_t index) {
+#if YAECS_PROFILE
+            const uint64_t begin = Profiler::Shared().Now();
+#endif
+            systems[index]->execute();
+            System* system = _bases[index];
+            if (system && system->world_) system->_last_run_tick = system->world_->AdvanceTick() - 1;
+#if YAECS_PROFILE
+            const uint64_t processed = system ? std::exchange(system->_processed, 0) : 0;
+            Profiler::Shared().Record(Profiler::Event{_names[index], "system", begin, Profiler::Shared().Now(), processed},
+                system ? &system->_profile : nullptr);
+#endif
+        }
+
+        static void ExecuteNode(void* context, size_t index) {
+            auto collection = static_cast<SystemCollection*>(context);
+            collection->Run(index);
+
+            for (auto dependent : collection->_nodes[index].dependents) {
+                if (collection->_nodes[dependent].remaining.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                    collection->_thread_pool->Submit(ThreadPool::Task{&ExecuteNode, collection, dependent, collection->_counter});
+            }
+        }
+
+        // in insertion order, it defines order between conflicting systems
+        std::vector<std::shared_ptr<ISystem>> systems{};
+
+        ThreadPool* _thread_pool = &ThreadPool::Shared();
+        std::unique_ptr<Node[]> _nodes{};
+        std::vector<System*> _bases{};
+        std::vector<CommandBuffer*> _buffers{};
+        std::atomic<size_t>* _counter = nullptr;
+        bool _dirty = true;
+#if YAECS_PROFILE
+        const char* _name = nullptr;
+        std::vector<const char*> _names{}; // by system index
+#endif
     };
 
     // System Templates (you can add yours)
 
-    template <typename TComponent>
+    // TComponent pool is cached and written, TAccess declares other used components as Read<...> or Write<...>
+    template <typename TComponent, typename... TAccess>
     class BaseSystem : public System, public IRunSystem, public IInitSystem, public IDestroySystem {
     public:
+        BaseSystem() {
+            _access.AddWrite<TComponent>();
+            (_access.Add(TAccess{}), ...);
+        }
+
         void init() override {
             _pool = world(). template /*wtf template here*/ GetPool<TComponent>();
         }
@@ -93,7 +305,7 @@ namespace ecs {
         }
         
     protected:
-        std::shared_ptr<ecs::ComponentPool<TComponent>> _pool;
+        ecs::pool_for<TComponent>* _pool = nullptr; // owned by world
     };
 
 
@@ -120,8 +332,7 @@ namespace ecs {
 
             auto system = std::make_shared<TSystem>();
             auto baseSystem = std::static_pointer_cast<System>(system);
-            // TODO maybe later refactor
-            baseSystem->world_ = std::make_unique<World>(world_);
+            baseSystem->world_ = &world_;
             _systems.insert_or_assign(system_type, baseSystem);
             return system;
         }
@@ -182,7 +393,7 @@ namespace ecs {
         }
         
     private:
-        World world_;
+        World& world_;
         std::unordered_map<type_index, std::shared_ptr<System>> _systems{};
         std::unordered_map<type_index, std::shared_ptr<ISystem>> _system_collections{};
     };
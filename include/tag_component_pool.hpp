@@ -0,0 +1,263 @@
+#pragma once
+
+#include "base.hpp"
+#include "component_pool.hpp"
+#include "thread_pool.hpp"
+
+#include <vector>
+#include <type_traits>
+#include <cassert>
+#include <algorithm>
+#include <limits>
+#include <span>
+#include <utility>
+#include <memory_resource>
+
+namespace ecs {
+
+    // empty components (struct Dead {}) are tags, they get TagComponentPool
+    template <typename TComponent>
+    inline constexpr bool is_tag_v = std::is_empty_v<TComponent>;
+
+    // Tag Component Pool
+    // Membership-only sparse set for empty components: nothing is stored per component, only entity and tick
+    // of insert. Add/remove is swap-and-pop of entity and signature bit, there are no pages to allocate.
+    // All components are the same shared instance, so views get them without lookup and tag in view
+    // costs only the bit of signature mask. Tag has no state to change, so its changed tick is added tick
+
+    template <typename TComponent>
+    class TagComponentPool final : public IComponentPool {
+        static_assert(is_tag_v<TComponent>, "Tag component must be empty type");
+        static_assert(std::is_default_constructible_v<TComponent>, "Cannot create pool for component which doesn't has default constructor");
+
+    public:
+        static constexpr size_t PARALLEL_ALIGNMENT = CACHE_LINE_SIZE / sizeof(entity);
+
+        using reference = TComponent&;
+        using const_reference = const TComponent&;
+
+    public: // Core
+
+        TagComponentPool(uint32_t reserve_entities = DEFAULT_ENTITIES_CAPACITY,
+            std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+            : _resource{resource}, _sparse{resource}, _dense{resource}, _added{resource} {
+            resize(reserve_entities);
+        }
+        TagComponentPool(TagComponentPool&& other) noexcept
+            : _resource{other._resource}, _sparse{std::move(other._sparse)},
+            _dense{std::move(other._dense)}, _added{std::move(other._added)} {
+            SetTick(other.GetTick());
+        }
+        TagComponentPool(const TagComponentPool& other)
+            : _resource{other._resource}, _sparse{other._sparse, other._resource},
+            _dense{other._dense, other._resource}, _added{other._added, other._resource} {
+            SetTick(other.GetTick());
+        }
+        TagComponentPool& operator=(TagComponentPool&&) = delete;
+        TagComponentPool& operator=(const TagComponentPool&) = delete;
+
+        void reserve(size_t new_capacity) override {
+            _dense.reserve(new_capacity);
+            _added.reserve(new_capacity);
+        }
+        void resize(size_t new_size) override {
+            assert((new_size >= _sparse.size() || std::all_of(_sparse.begin() + new_size, _sparse.end(),
+                [](const uint32_t index) { return index == NULL_INDEX; })) && "Can't erase entities with components");
+            _sparse.resize(new_size, NULL_INDEX);
+        }
+        void shrink_to_fit() override {
+            _dense.shrink_to_fit();
+            _added.shrink_to_fit();
+        }
+
+        void clear() override {
+            std::fill(_sparse.begin(), _sparse.end(), NULL_INDEX);
+            _dense.clear();
+            _added.clear();
+        }
+        void reset() override {
+            clear();
+            shrink_to_fit();
+        }
+
+        // inserting existing tag changes nothing
+        void InsertComponent(const entity entity, TComponent = {}) {
+            assert(GetEntityIndex(entity) < _sparse.size() && "Entity out of range");
+            uint32_t& index = _sparse[GetEntityIndex(entity)];
+            if (index != NULL_INDEX) {
+                assert(_dense[index] == entity && "Component belongs to other version of entity");
+                return;
+            }
+            index = static_cast<uint32_t>(_dense.size());
+            _dense.push_back(entity);
+            _added.push_back(GetTick());
+        }
+        void InsertComponents(std::span<const entity> entities, std::span<const TComponent> components) {
+            assert(entities.size() == components.size() && "Count of entities and components must be equal");
+            InsertComponents(entities, TComponent{});
+        }
+        void InsertComponents(std::span<const entity> entities, const TComponent& = {}) {
+            const size_t required = _dense.size() + entities.size();
+            if (required > _dense.capacity()) reserve(std::max(required, _dense.capacity() * 2));
+            for (auto entity : entities) InsertComponent(entity);
+        }
+        void RemoveComponent(const entity entity) override {
+            assert(ContainsComponent(entity) && "Entity doesn't have that component");
+
+            uint32_t index = _sparse[GetEntityIndex(entity)];
+            uint32_t last = static_cast<uint32_t>(_dense.size() - 1);
+            if (index != last) { // move last into the hole
+                ecs::entity moved = _dense[last];
+                _dense[index] = moved;
+                _added[index] = _added[last];
+                _sparse[GetEntityIndex(moved)] = index;
+            }
+            _dense.pop_back();
+            _added.pop_back();
+            _sparse[GetEntityIndex(entity)] = NULL_INDEX;
+        }
+        [[nodiscard]] bool ContainsComponent(const entity entity) const override {
+            const entity_index index = GetEntityIndex(entity);
+            return index < _sparse.size() && _sparse[index] != NULL_INDEX && _dense[_sparse[index]] == entity;
+        }
+        // shared instance, membership is checked by signature before
+        TComponent& GetComponent([[maybe_unused]] const entity entity) {
+            assert(ContainsComponent(entity) && "Entity doesn't have that component");
+            return _instance;
+        }
+        [[nodiscard]] const TComponent& operator[]([[maybe_unused]] const entity entity) const {
+            assert(ContainsComponent(entity) && "Entity doesn't have that component");
+            return _instance;
+        }
+
+        [[nodiscard]] bool IsAdded(const entity entity, const tick since) const {
+            assert(ContainsComponent(entity) && "Entity doesn't have that component");
+            return _added[_sparse[GetEntityIndex(entity)]] > since;
+        }
+        [[nodiscard]] bool IsChanged(const entity entity, const tick since) const { return IsAdded(entity, since); }
+        void MarkChanged(const entity) { }
+
+        [[nodiscard]] size_t GetIndex(const entity entity) const override {
+            assert(ContainsComponent(entity) && "Entity doesn't have that component");
+            return _sparse[GetEntityIndex(entity)];
+        }
+        [[nodiscard]] entity GetEntityAt(const size_t index) const {
+            assert(index < _dense.size() && "Index out of range");
+            return _dense[index];
+        }
+        [[nodiscard]] TComponent& GetComponentAt(const size_t) { return _instance; }
+        [[nodiscard]] const TComponent& GetComponentAt(const size_t) const { return _instance; }
+        [[nodiscard]] tick GetAddedTickAt(const size_t index) const { return _added[index]; }
+        [[nodiscard]] tick GetChangedTickAt(const size_t index) const { return _added[index]; }
+        void SwapIndexes(const size_t index1, const size_t index2) override {
+            assert(index1 < _dense.size() && index2 < _dense.size() && "Index out of range");
+            if (index1 == index2) return;
+            std::swap(_dense[index1], _dense[index2]);
+            std::swap(_added[index1], _added[index2]);
+            _sparse[GetEntityIndex(_dense[index1])] = static_cast<uint32_t>(index1);
+            _sparse[GetEntityIndex(_dense[index2])] = static_cast<uint32_t>(index2);
+        }
+
+        // tags are equal, so only compare(entity, entity) orders them
+        template <typename Compare>
+        void Sort(Compare compare, const SortAlgorithm algorithm = SortAlgorithm::Full) {
+            SortIndexes(0, size(), PoolLess(*this, compare), [this](const size_t a, const size_t b) { SwapIndexes(a, b); }, algorithm);
+        }
+
+        // func(TComponent&) or func(entity, TComponent&) for every tagged entity
+        template <typename Func>
+        void ParallelForEach(Func func, const size_t grain = DEFAULT_PARALLEL_GRAIN,
+            ThreadPool& thread_pool = ThreadPool::Shared()) {
+            auto chunk = [this, &func](const size_t begin, const size_t end) {
+                for (size_t index = begin; index < end; index++) {
+                    if constexpr (std::is_invocable_v<Func, entity, TComponent&>) func(_dense[index], _instance);
+                    else func(_instance);
+                }
+            };
+            thread_pool.ParallelChunks(_dense.size(), grain, PARALLEL_ALIGNMENT, chunk);
+        }
+
+        [[nodiscard]] size_t size() const override { return _dense.size(); }
+        [[nodiscard]] const entity* data() const override { return _dense.data(); }
+        [[nodiscard]] size_t capacity() const { return _dense.capacity(); }
+        [[nodiscard]] PoolStats MemoryStats() const override {
+            PoolStats stats{};
+            stats.count = _dense.size();
+            stats.capacity = capacity();
+            stats.sparse_bytes = _sparse.capacity() * sizeof(uint32_t);
+            stats.used_bytes = _sparse.size() * sizeof(uint32_t) + _dense.size() * (sizeof(entity) + sizeof(tick));
+            stats.reserved_bytes = stats.sparse_bytes + _dense.capacity() * sizeof(entity) + _added.capacity() * sizeof(tick);
+            return stats;
+        }
+        [[nodiscard]] std::pmr::memory_resource* GetResource() const { return _resource; }
+
+    public: // Snapshot
+
+        // payload is entities and added ticks, tags are always written
+        [[nodiscard]] SnapshotPoolHeader GetSnapshotHeader() const override {
+            return SnapshotPoolHeader{SnapshotTypeHash<TComponent>(), 0, sizeof(TComponent), static_cast<uint32_t>(_dense.size()),
+                SnapshotPoolHeader::RAW, 0};
+        }
+        void SaveSnapshot(SnapshotWriter& writer) const override {
+            const size_t count = _dense.size();
+            SnapshotPoolHeader header = GetSnapshotHeader();
+            header.payload_bytes = GetSnapshotPayloadBytes(count);
+            writer.Write(header);
+            writer.Align();
+            writer.Block(_dense.data(), count * sizeof(entity));
+            writer.Block(_added.data(), count * sizeof(tick));
+        }
+        [[nodiscard]] bool CanLoadSnapshot(const SnapshotPoolHeader& header) const override {
+            return header.type_hash == SnapshotTypeHash<TComponent>() && header.component_size == sizeof(TComponent)
+                && (header.flags & SnapshotPoolHeader::RAW);
+        }
+        [[nodiscard]] size_t GetSnapshotPayloadBytes(const size_t count) const override {
+            return SnapshotAligned(count * sizeof(entity)) + SnapshotAligned(count * sizeof(tick));
+        }
+        void LoadSnapshot(const SnapshotPoolHeader& header, SnapshotReader& reader) override {
+            clear();
+            const size_t count = header.count;
+            const std::byte* entities = reader.Block(count * sizeof(entity));
+            const std::byte* added = reader.Block(count * sizeof(tick));
+            assert(entities && added && "Snapshot payload is out of range");
+
+            _dense.resize(count);
+            _added.resize(count);
+            if (count == 0) return;
+            std::memcpy(_dense.data(), entities, count * sizeof(entity));
+            std::memcpy(_added.data(), added, count * sizeof(tick));
+            for (size_t index = 0; index < count; index++) {
+                assert(GetEntityIndex(_dense[index]) < _sparse.size() && "Entity out of range");
+                _sparse[GetEntityIndex(_dense[index])] = static_cast<uint32_t>(index);
+            }
+        }
+
+    public: // Deltas
+
+        // tags have no bytes, delta records of them are inserts only
+        [[nodiscard]] bool IsTriviallyCopyable() const override { return true; }
+        [[nodiscard]] size_t GetPackedSize() const override { return 0; }
+        [[nodiscard]] std::span<const tick> GetChangedTicks() const override { return _added; }
+        void ReadPacked(const size_t, std::byte*) const override { }
+        void ReadSnapshotPacked(const std::byte*, const size_t, const size_t, std::byte*) const override { }
+        void ApplyPacked(const entity entity, const std::byte*, const bool patch) override {
+            if (!patch) InsertComponent(entity);
+        }
+
+    public: // Iterators
+
+        // iterate packed entities, which have component
+        [[nodiscard]] auto begin_ent_active() const { return _dense.cbegin(); }
+        [[nodiscard]] auto end_ent_active() const { return _dense.cend(); }
+
+    private:
+        static constexpr uint32_t NULL_INDEX = std::numeric_limits<uint32_t>::max();
+
+        inline static TComponent _instance{};
+
+        std::pmr::memory_resource* _resource;
+        std::pmr::vector<uint32_t> _sparse;
+        std::pmr::vector<entity> _dense;
+        std::pmr::vector<tick> _added; // tick of insert, packed as _dense
+    };
+}
@@ -0,0 +1,198 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ecs {
+
+    // Work stealing thread pool
+    // Every worker has own queue, it pops own tasks from back and steals from front of others.
+    // Tasks are plain function pointers with context, so submit doesn't allocate closures.
+    // Waiting threads execute tasks too, so tasks can wait other tasks without deadlocks
+
+    class ThreadPool {
+    public:
+        struct Task {
+            void (*func)(void* context, size_t index);
+            void* context;
+            size_t index;
+            std::atomic<size_t>* counter; // decremented after func returns
+        };
+
+    public:
+        explicit ThreadPool(size_t workers_count = DefaultWorkersCount())
+            : _queues{std::make_unique<Queue[]>(workers_count + 1)}, _queues_count{workers_count + 1} {
+            _threads.reserve(workers_count);
+            for (size_t index = 1; index <= workers_count; index++)
+                _threads.emplace_back([this, index]() { WorkerLoop(index); });
+        }
+        ~ThreadPool() {
+            {
+                std::lock_guard lock{_sleep_mutex};
+                _stop = true;
+            }
+            _sleep.notify_all();
+            for (auto& thread : _threads) thread.join();
+        }
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        // Shared pool, created on first use with (hardware threads - 1) workers
+        [[nodiscard]] static ThreadPool& Shared() {
+            static ThreadPool pool{};
+            return pool;
+        }
+        [[nodiscard]] static size_t DefaultWorkersCount() {
+            const size_t hardware = std::thread::hardware_concurrency();
+            return hardware > 1 ? hardware - 1 : 0;
+        }
+
+        // workers + calling thread
+        [[nodiscard]] size_t GetThreadsCount() const { return _queues_count; }
+        // 1..workers for workers of this pool, 0 for any other thread
+        [[nodiscard]] size_t GetThreadIndex() const {
+            return CurrentPool() == this ? CurrentIndex() : 0;
+        }
+
+    public: // Tasks
+
+        // task.counter must be already increased by caller
+        void Submit(const Task& task) {
+            Queue& queue = _queues[GetThreadIndex()];
+            {
+                std::lock_guard lock{queue.mutex};
+                queue.tasks.push_back(task);
+            }
+            _pending.fetch_add(1, std::memory_order_release);
+            { std::lock_guard lock{_sleep_mutex}; }
+            _sleep.notify_one();
+        }
+
+        // runs tasks until counter reaches 0
+        void Wait(const std::atomic<size_t>& counter) {
+            while (counter.load(std::memory_order_acquire) > 0) {
+                if (!RunOne()) std::this_thread::yield();
+            }
+        }
+
+        // func(index) for index in [0, count), returns when all calls are finished
+        template <typename Func>
+        void ParallelFor(const size_t count, Func& func) {
+            if (count == 0) return;
+            if (count == 1 || _queues_count == 1) {
+                for (size_t index = 0; index < count; index++) func(index);
+                return;
+            }
+
+            std::atomic<size_t> counter{count};
+            for (size_t index = 1; index < count; index++)
+                Submit(Task{&Invoke<Func>, &func, index, &counter});
+            func(0);
+            counter.fetch_sub(1, std::memory_order_release);
+            Wait(counter);
+        }
+
+        // func(begin, end) for chunks of [0, count), every chunk except last has multiple of alignment elements
+        // and at least grain elements, there are up to 4 chunks per thread for load balancing
+        template <typename Func>
+        void ParallelChunks(const size_t count, const size_t grain, const size_t alignment, Func& func) {
+            if (count == 0) return;
+
+            const size_t balanced = (count + _queues_count * 4 - 1) / (_queues_count * 4);
+            size_t chunk = std::max({grain, balanced, size_t{1}});
+            chunk = (chunk + alignment - 1) / alignment * alignment;
+            const size_t chunks = (count + chunk - 1) / chunk;
+
+            auto invoke = [&func, count, chunk](const size_t index) {
+                const size_t begin = index * chunk;
+                func(begin, std::min(begin + chunk, count));
+            };
+            ParallelFor(chunks, invoke);
+        }
+
+    private:
+        struct alignas(64) Queue {
+            std::mutex mutex;
+            std::deque<Task> tasks;
+        };
+
+        template <typename Func>
+        static void Invoke(void* context, size_t index) {
+            (*static_cast<Func*>(context))(index);
+        }
+
+        bool RunOne() {
+            Task task;
+            if (!Pop(task)) return false;
+            task.func(task.context, task.index);
+            task.counter->fetch_sub(1, std::memory_order_release);
+            return true;
+        }
+
+        bool Pop(Task& task) {
+            if (_pending.load(std::memory_order_acquire) == 0) return false;
+
+            const size_t own = GetThreadIndex();
+            { // own queue, LIFO for cache locality
+                Queue& queue = _queues[own];
+                std::lock_guard lock{queue.mutex};
+                if (!queue.tasks.empty()) {
+                    task = queue.tasks.back();
+                    queue.tasks.pop_back();
+                    _pending.fetch_sub(1, std::memory_order_relaxed);
+                    return true;
+                }
+            }
+            for (size_t offset = 1; offset < _queues_count; offset++) { // steal, FIFO
+                Queue& queue = _queues[(own + offset) % _queues_count];
+                std::lock_guard lock{queue.mutex};
+                if (!queue.tasks.empty()) {
+                    task = queue.tasks.front();
+                    queue.tasks.pop_front();
+                    _pending.fetch_sub(1, std::memory_order_relaxed);
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        void WorkerLoop(const size_t index) {
+            CurrentPool() = this;
+            CurrentIndex() = index;
+
+            while (true) {
+                if (RunOne()) continue;
+
+                std::unique_lock lock{_sleep_mutex};
+                _sleep.wait(lock, [this]() { return _stop || _pending.load(std::memory_order_acquire) > 0; });
+                if (_stop) return;
+            }
+        }
+
+        static const ThreadPool*& CurrentPool() {
+            thread_local const ThreadPool* pool = nullptr;
+            return pool;
+        }
+        static size_t& CurrentIndex() {
+            thread_local size_t index = 0;
+            return index;
+        }
+
+        std::unique_ptr<Queue[]> _queues;
+        size_t _queues_count;
+        std::vector<std::thread> _threads;
+
+        std::atomic<size_t> _pending{0};
+        std::mutex _sleep_mutex;
+        std::condition_variable _sleep;
+        bool _stop = false;
+    };
+}
@@ -0,0 +1,199 @@
+#pragma once
+
+#include "base.hpp"
+#include "component_pool.hpp"
+#include "soa_component_pool.hpp"
+#include "thread_pool.hpp"
+#include "signature.hpp"
+
+#include <tuple>
+#include <type_traits>
+#include <cassert>
+#include <utility>
+#include <numeric>
+
+namespace ecs {
+
+    // Query filters, component is passed to view functions as usual:
+    //     world.View<Changed<Position>, const Velocity>(since)
+    // Added<T> - T was inserted after since tick, Changed<T> - T was inserted or mutably accessed after since tick.
+    // const T - read only access, which doesn't stamp changed tick
+
+    template <typename TComponent>
+    struct Added {};
+    template <typename TComponent>
+    struct Changed {};
+
+    template <typename TQuery>
+    struct query_traits {
+        using component = std::remove_const_t<TQuery>;
+        static constexpr bool read_only = std::is_const_v<TQuery>;
+        static constexpr bool added = false;
+        static constexpr bool changed = false;
+    };
+    template <typename TComponent>
+    struct query_traits<Added<TComponent>> : query_traits<TComponent> {
+        static constexpr bool added = true;
+    };
+    template <typename TComponent>
+    struct query_traits<Changed<TComponent>> : query_traits<TComponent> {
+        static constexpr bool changed = true;
+    };
+    template <typename TQuery>
+    using query_component_t = typename query_traits<TQuery>::component;
+
+    // View
+    // Iterates entities which have all TComponents. Iteration is driven by the smallest pool,
+    // membership is tested with precomputed mask against world's signature matrix,
+    // then added/changed ticks of filtered components are compared with since
+
+    template <typename... TComponents>
+    class View {
+        static_assert(sizeof...(TComponents) > 0, "View requires at least one component");
+
+        template <typename TQuery>
+        using pool_type = pool_for<query_component_t<TQuery>>;
+        template <typename TQuery>
+        using reference_type = std::conditional_t<query_traits<TQuery>::read_only,
+            typename pool_type<TQuery>::const_reference, typename pool_type<TQuery>::reference>;
+
+        static constexpr bool FILTERED = ((query_traits<TComponents>::added || query_traits<TComponents>::changed) || ...);
+
+    public:
+        using value_type = std::tuple<reference_type<TComponents>...>;
+
+        // lead pool is chosen at runtime, so chunks of parallel iteration start on cache line of every pool,
+        // as components and changed ticks of lead are written at dense indexes of its entities
+        static constexpr size_t PARALLEL_ALIGNMENT = [] {
+            size_t alignment = CACHE_LINE_SIZE / sizeof(entity);
+            ((alignment = std::lcm(alignment, pool_type<TComponents>::PARALLEL_ALIGNMENT)), ...);
+            return alignment;
+        }();
+
+        class iterator {
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using difference_type = std::ptrdiff_t;
+
+            iterator(const View* view, const entity* ptr, const entity* end)
+                : _view{view}, _ptr{ptr}, _end{end} { skip(); }
+
+            value_type operator*() const { return _view->Get(*_ptr); }
+            [[nodiscard]] entity GetEntity() const { return *_ptr; }
+
+            iterator& operator++() { // Prefix increment
+                ++_ptr;
+                skip();
+                return *this;
+            }
+            iterator operator++(int) { // Postfix increment
+                iterator tmp = *this;
+                ++(*this);
+                return tmp;
+            }
+
+            [[nodiscard]] friend bool operator== (const iterator& a, const iterator& b)
+                { return a._ptr == b._ptr; };
+            [[nodiscard]] friend bool operator!= (const iterator& a, const iterator& b)
+                { return a._ptr != b._ptr; };
+
+        private:
+            void skip() {
+                while (_ptr != _end && !_view->Contains(*_ptr)) ++_ptr;
+            }
+
+            const View* _view;
+            const entity* _ptr;
+            const entity* _end;
+        };
+
+    public:
+        View(const signature* signatures, const signature& mask, pool_type<TComponents>*... pools, const tick since = 0)
+            : _signatures{signatures}, _mask{mask}, _pools{pools...}, _since{since} {
+            assert(((pools != nullptr) && ...) && "View requires registered components");
+            _lead = static_cast<IComponentPool*>(std::get<0>(_pools));
+            ((_lead = pools->size() < _lead->size() ? static_cast<IComponentPool*>(pools) : _lead), ...);
+        }
+
+        [[nodiscard]] bool Contains(const entity entity) const {
+            if (!_mask.is_subset_of(_signatures[GetEntityIndex(entity)])) return false;
+            if constexpr (FILTERED) return (Passes<TComponents>(entity) && ...);
+            return true;
+        }
+        [[nodiscard]] value_type Get(const entity entity) const {
+            return value_type{GetComponent<TComponents>(entity)...};
+        }
+
+        // func(entity, TComponents&...) or func(TComponents&...), const components are passed as const references,
+        // SoA components as proxy references
+        template <typename Func>
+        void Each(Func func) const {
+            const entity* ptr = _lead->data();
+            const entity* end = ptr + _lead->size();
+            for (; ptr != end; ++ptr) {
+                const entity entity = *ptr;
+                if (!Contains(entity)) continue;
+
+                if constexpr (std::is_invocable_v<Func, ecs::entity, reference_type<TComponents>...>)
+                    func(entity, GetComponent<TComponents>(entity)...);
+                else
+                    func(GetComponent<TComponents>(entity)...);
+            }
+        }
+
+        // Each, but chunks of driving pool are processed on thread pool.
+        // Components of other pools are accessed by entity, so their writes are scattered anyway
+        template <typename Func>
+        void ParallelEach(Func func, const size_t grain = DEFAULT_PARALLEL_GRAIN, 
+            ThreadPool& thread_pool = ThreadPool::Shared()) const {
+            const entity* entities = _lead->data();
+            auto chunk = [this, &func, entities](const size_t begin, const size_t end) {
+                for (size_t index = begin; index < end; index++) {
+                    const entity entity = entities[index];
+                    if (!Contains(entity)) continue;
+
+                    if constexpr (std::is_invocable_v<Func, ecs::entity, reference_type<TComponents>...>)
+                        func(entity, GetComponent<TComponents>(entity)...);
+                    else
+                        func(GetComponent<TComponents>(entity)...);
+                }
+            };
+            thread_pool.ParallelChunks(_lead->size(), grain, PARALLEL_ALIGNMENT, chunk);
+        }
+
+        // upper bound of iterated entities
+        [[nodiscard]] size_t size_hint() const { return _lead->size(); }
+
+    public: // Iterators
+
+        [[nodiscard]] iterator begin() const {
+            const entity* ptr = _lead->data();
+            return iterator{this, ptr, ptr + _lead->size()};
+        }
+        [[nodiscard]] iterator end() const {
+            const entity* ptr = _lead->data() + _lead->size();
+            return iterator{this, ptr, ptr};
+        }
+
+    private:
+        template <typename TQuery>
+        [[nodiscard]] reference_type<TQuery> GetComponent(const entity entity) const {
+            auto pool = std::get<pool_type<TQuery>*>(_pools);
+            if constexpr (query_traits<TQuery>::read_only) return std::as_const(*pool)[entity];
+            else return pool->GetComponent(entity);
+        }
+        template <typename TQuery>
+        [[nodiscard]] bool Passes(const entity entity) const {
+            auto pool = std::get<pool_type<TQuery>*>(_pools);
+            if constexpr (query_traits<TQuery>::added) return pool->IsAdded(entity, _since);
+            else if constexpr (query_traits<TQuery>::changed) return pool->IsChanged(entity, _since);
+            else return true;
+        }
+
+        const signature* _signatures;
+        signature _mask;
+        std::tuple<pool_type<TComponents>*...> _pools;
+        IComponentPool* _lead;
+        tick _since;
+    };
+}
@@ -1,10 +1,18 @@
 #pragma once
 
 #include "dynamic_bitset.hpp"
+#include "signature.hpp"
 
 #include "base.hpp"
 #include "types.hpp"
 #include "component_pool.hpp"
+#include "soa_component_pool.hpp"
+#include "view.hpp"
+#include "group.hpp"
+#include "command_buffer.hpp"
+#include "observers.hpp"
+#include "snapshot.hpp"
+#include "hierarchy.hpp"
 
 #include <atomic>
 #include <vector>
@@ -13,13 +21,24 @@
 #include <queue>
 #include <bitset>
 #include <set>
+#include <span>
+#include <algorithm>
+#include <utility>
+#include <memory_resource>
+#include <cstring>
+#include <fstream>
+#include <ostream>
+#include <string>
 
 namespace ecs {
 
     class World {
     public:
+        // resource is used by signatures, entities and all component pools of world
         World(uint32_t default_entities_capacity = DEFAULT_ENTITIES_CAPACITY, 
-            uint32_t default_entity_capacity = DEFAULT_ENTITY_CAPACITY) {
+            uint32_t default_entity_capacity = DEFAULT_ENTITY_CAPACITY,
+            std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+            : _resource{resource}, _signatures{resource}, _entities{resource} {
             
             resize_entities(default_entities_capacity);
             resize_entity(default_entity_capacity);
@@ -27,11 +46,10 @@ namespace ecs {
         }
 
     private:
-        #define assert_entity_range(entity) assert(entity < _entities_capacity && "Entity out of range");
+        #define assert_entity_range(entity) assert(GetEntityIndex(entity) < _entities_capacity && "Entity out of range");
         #define assert_component_types() assert(_components.size() <= _entity_capacity && "Count of registered components is bigger than entity capacity");
-        #define assert_signature_exists(entity) assert(_signatures.contains(entity) && "Entity's signature doesn't exists");
-        #define assert_destroyed_entity(entity) assert(_available_entities.contains(entity) && "Entity doesn't destroyed");
-        #define assert_created_entity(entity) assert(!_available_entities.contains(entity) && "Entity doesn't created");
+        #define assert_signature_exists(entity) assert(GetEntityIndex(entity) < _signatures.size() && "Entity's signature doesn't exists");
+        #define assert_created_entity(entity) assert(ExistsEntity(entity) && "Entity doesn't created or already destroyed");
 
     public:
         class iterator {
@@ -75,80 +93,156 @@ namespace ecs {
         
     public: // Entities
 
+        // Destroyed slots form implicit free list inside _entities: index part of free slot
+        // is the next free index, version part is the version for the next recycle
         [[nodiscard]] entity CreateEntity() {
-            assert(_available_entities.size() > 0 && "Doesn't have available entities, do expand entities capacity");
-
-            entity newEntity = *_available_entities.begin();
+            _entities_count++;
 
-            assert_destroyed_entity(newEntity);
-            _available_entities.erase(newEntity);
-            _signatures.insert_or_assign(newEntity, dynamic_bitset{_entity_capacity});
+            if (_free_entity == NULL_ENTITY_INDEX) {
+                assert(_entities.size() < _entities_capacity && "Doesn't have available entities, do expand entities capacity");
+                entity_index index = static_cast<entity_index>(_entities.size());
+                return _entities.emplace_back(MakeEntity(index, 0));
+            }
 
-            _entities_count++;
-            return newEntity;
+            entity_index index = _free_entity;
+            entity& slot = _entities[index];
+            _free_entity = GetEntityIndex(slot);
+            slot = MakeEntity(index, GetEntityVersion(slot));
+            return slot;
         }
         
+        // destroys subtree of entity in hierarchy too
         void DestroyEntity(const entity entity) {
             assert(_entities_count > 0 && "All entities already destroyed");
+            assert_created_entity(entity);
             
+            if (IsHierarchyNode(entity)) {
+                Unlink(entity);
+                _hierarchy_nodes.clear();
+                CollectDescendants(entity, _hierarchy_nodes);
+                for (auto descendant : _hierarchy_nodes) {
+                    RemoveAllComponents(descendant);
+                    ReleaseEntity(descendant);
+                }
+            }
             RemoveAllComponents(entity);
-            
-            assert_entity_range(entity);
-            assert_signature_exists(entity);
-            _signatures.erase(entity);
+            ReleaseEntity(entity);
+        }
 
-            assert_created_entity(entity);
-            _available_entities.insert(entity);
-            
-            _entities_count--;
+        // Creates count entities to out, recycled indexes first, then appends new indexes in one step
+        void CreateEntities(const size_t count, std::span<entity> out) {
+            assert(out.size() >= count && "Output span is too small");
+
+            size_t created = 0;
+            for (; created < count && _free_entity != NULL_ENTITY_INDEX; created++)
+                out[created] = CreateEntity();
+
+            const size_t fresh = count - created;
+            const entity_index first = static_cast<entity_index>(_entities.size());
+            assert(first + fresh <= _entities_capacity && "Doesn't have available entities, do expand entities capacity");
+            _entities.resize(first + fresh);
+            for (size_t i = 0; i < fresh; i++) {
+                const entity_index index = first + static_cast<entity_index>(i);
+                _entities[index] = MakeEntity(index, 0);
+                out[created + i] = _entities[index];
+            }
+            _entities_count += static_cast<uint32_t>(fresh);
+        }
+
+        // Removes components pool by pool, so every pool is looked up once. Subtrees in hierarchy are destroyed too:
+        // all entities are detached first, so descendants of one are never entities of others
+        void DestroyEntities(std::span<const entity> entities) {
+            assert(_entities_count >= entities.size() && "All entities already destroyed");
+            assert_component_types();
+
+            if (_hierarchy != NULL_COMPONENT && _pools[_hierarchy]->size() > 0) {
+                _hierarchy_nodes.assign(entities.begin(), entities.end());
+                for (auto entity : entities)
+                    if (IsHierarchyNode(entity)) Unlink(entity);
+                for (auto entity : entities)
+                    if (IsHierarchyNode(entity)) CollectDescendants(entity, _hierarchy_nodes);
+                entities = _hierarchy_nodes;
+            }
+
+            for (size_t i = 0; i < _components.size(); i++) {
+                auto group = _component_groups[i];
+                auto observers = _component_observers[i].get();
+                auto pool = _pools[i].get();
+                for (auto entity : entities) {
+                    assert_created_entity(entity);
+                    if (!_signatures[GetEntityIndex(entity)].get(i)) continue;
+                    if (group) group->OnRemove(entity);
+                    if (observers) observers->RecordRemove(entity, *pool);
+                    pool->RemoveComponent(entity);
+                }
+            }
+            for (auto entity : entities) {
+                assert_created_entity(entity);
+                ReleaseEntity(entity);
+            }
         }
 
-        bool ExistsEntity(const entity entity) {
-            if (entity >= _entities_capacity) return false;
-            if (_entities_count == 0) return false;
-            return !_available_entities.contains(entity);
+        // false for destroyed and recycled (stale) entities
+        [[nodiscard]] bool ExistsEntity(const entity entity) const {
+            entity_index index = GetEntityIndex(entity);
+            return index < _entities.size() && _entities[index] == entity;
         }
 
-        [[nodiscard]] dynamic_bitset& GetSignature(const entity entity) {
+        [[nodiscard]] uint32_t GetEntitiesCount() const { return _entities_count; }
+
+        [[nodiscard]] signature& GetSignature(const entity entity) {
             assert_entity_range(entity);
             assert_signature_exists(entity);
             assert_created_entity(entity);
 
-            return _signatures[entity];
+            return _signatures[GetEntityIndex(entity)];
         }
-        void SetSignature(const entity entity, dynamic_bitset signature) {
+        void SetSignature(const entity entity, const signature& signature) {
             assert_entity_range(entity);
             assert_signature_exists(entity);
             assert_created_entity(entity);
 
-            _signatures[entity] = signature;
+            _signatures[GetEntityIndex(entity)] = signature;
         }
         
     public: // Component Pools
 
+        // Component gets dense index of this world (registration order), it is index of signature bit and pool.
+        // Global type index is mapped to it with flat array, so lookups are indexed loads without hashing
         template <typename TComponent>
         void RegisterComponent() {
             type_index component_type = TypeIndexator<TComponent>::value();
-            assert(!_component_pools.contains(component_type) && "Component already registered");
+            assert(!IsRegistered(component_type) && "Component already registered");
 
-            auto pool = std::make_shared<ComponentPool<TComponent>>(_entities_capacity);
-            auto interfacePool = std::static_pointer_cast<IComponentPool>(pool);
-            _component_pools.insert_or_assign(component_type, interfacePool);
+            std::pmr::polymorphic_allocator<> allocator{_resource};
+            auto pool = allocator.new_object<pool_for<TComponent>>(_entities_capacity, _resource);
+            pool->SetTick(GetTick());
 
-            _component_indexes.insert_or_assign(component_type, _components.size());
+            if (component_type >= _component_ids.size()) _component_ids.resize(component_type + 1, NULL_COMPONENT);
+            _component_ids[component_type] = static_cast<component_index>(_components.size());
             _components.emplace_back(component_type);
+            _pools.emplace_back(pool, PoolDeleter{&DeletePool<pool_for<TComponent>>, _resource});
+            _component_groups.emplace_back(nullptr);
+            _component_observers.emplace_back(nullptr);
+            if constexpr (std::is_same_v<TComponent, Hierarchy>) _hierarchy = _component_ids[component_type];
         }
 
         // UnregisterComponent is a lost feature, to hard to implement
 
         template <typename TComponent>
-        [[nodiscard]] size_t GetComponentTypeIndex() {
+        [[nodiscard]] bool IsRegistered() const { return IsRegistered(TypeIndexator<TComponent>::value()); }
+        [[nodiscard]] bool IsRegistered(const type_index component_type) const {
+            return component_type < _component_ids.size() && _component_ids[component_type] != NULL_COMPONENT;
+        }
+
+        template <typename TComponent>
+        [[nodiscard]] size_t GetComponentTypeIndex() const {
             type_index component_type = TypeIndexator<TComponent>::value();
             return GetComponentTypeIndex(component_type);
         }
-        [[nodiscard]] size_t GetComponentTypeIndex(const type_index component_type) {
-            assert(_component_pools.contains(component_type) && "Component is not registered");
-            return _component_indexes[component_type];
+        [[nodiscard]] size_t GetComponentTypeIndex(const type_index component_type) const {
+            assert(IsRegistered(component_type) && "Component is not registered");
+            return _component_ids[component_type];
         }
 
     public: // Components
@@ -156,7 +250,23 @@ namespace ecs {
         template <typename TComponent>
         void AddComponent(const entity entity, TComponent component) {
             assert(!ContainsComponent<TComponent>(entity) && "Already contains this component in this entity");
-            InsertComponent(entity, component);
+            InsertComponent(entity, std::move(component));
+        }
+
+        // world.InsertComponents<Position>(entities, positions), pool is looked up and reserved once
+        template <typename TComponent>
+        void InsertComponents(std::span<const entity> entities, std::span<const TComponent> components) {
+            assert(entities.size() == components.size() && "Count of entities and components must be equal");
+            auto pool = GetPool<TComponent>();
+            pool->InsertComponents(entities, components);
+            SetSignatures(entities, GetComponentTypeIndex<TComponent>());
+        }
+        // inserts copy of component to every entity
+        template <typename TComponent>
+        void InsertComponents(std::span<const entity> entities, const TComponent& component) {
+            auto pool = GetPool<TComponent>();
+            pool->InsertComponents(entities, component);
+            SetSignatures(entities, GetComponentTypeIndex<TComponent>());
         }
 
         template <typename TComponent>
@@ -164,14 +274,18 @@ namespace ecs {
             assert_entity_range(entity);
 
             auto pool = GetPool<TComponent>();
-            pool->InsertComponent(entity, component);
+            pool->InsertComponent(entity, std::move(component));
             
             assert_signature_exists(entity);
             assert_created_entity(entity);
 
-            dynamic_bitset& signature = _signatures[entity];
+            signature& signature = _signatures[GetEntityIndex(entity)];
             size_t index = GetComponentTypeIndex<TComponent>();
+            if (auto observers = _component_observers[index].get())
+                signature.get(index) ? observers->RecordUpdate(entity) : observers->RecordAdd(entity);
             signature.set(index, true);
+
+            if (auto group = _component_groups[index]) group->OnInsert(entity);
         }
         
         template <typename TComponent>
@@ -180,30 +294,31 @@ namespace ecs {
             assert_signature_exists(entity);
             assert_created_entity(entity);
 
+            size_t index = GetComponentTypeIndex<TComponent>();
+            if (auto group = _component_groups[index]) group->OnRemove(entity);
+
             auto pool = GetPool<TComponent>();
+            if (auto observers = _component_observers[index].get()) observers->RecordRemove(entity, *pool);
             pool->RemoveComponent(entity);
 
-            dynamic_bitset& signature = _signatures[entity];
-            size_t index = GetComponentTypeIndex<TComponent>();
+            signature& signature = _signatures[GetEntityIndex(entity)];
             signature.set(index, false);
         }
 
         void RemoveAllComponents(const entity entity) {
-            auto signature = GetSignature(entity);
+            const signature& signature = GetSignature(entity);
             assert_component_types();
-            for (auto i = 0; i < _components.size(); i++)
-            {
-                if (!signature[i]) continue;
-                auto component_type = _components[i];
-                auto pool = GetPool(component_type);
-                pool->RemoveComponent(entity);
-            }
+            for (size_t i = signature.find_first(); i != signature::npos; i = signature.find_next(i))
+                RemoveComponent(entity, i);
         }
         
+        // TComponent& or proxy reference for SoA components, stamps changed tick.
+        // GetComponent<const TComponent> is read only access, which doesn't stamp
         template <typename TComponent>
-        [[nodiscard]] TComponent& GetComponent(const entity entity) {
-            auto pool = GetPool<TComponent>();
-            return pool->GetComponent(entity);
+        [[nodiscard]] decltype(auto) GetComponent(const entity entity) {
+            auto pool = GetPool<std::remove_const_t<TComponent>>();
+            if constexpr (std::is_const_v<TComponent>) return std::as_const(*pool)[entity];
+            else return pool->GetComponent(entity);
         }
 
         template <typename TComponent>
@@ -212,96 +327,927 @@ namespace ecs {
             assert_signature_exists(entity);
             assert_created_entity(entity);
 
-            dynamic_bitset& signature = _signatures[entity];
+            signature& signature = _signatures[GetEntityIndex(entity)];
             size_t index = GetComponentTypeIndex<TComponent>();
             return signature.get(index);
         }
 
+    public: // Views
+
+        // for (auto [position, velocity] : world.View<Position, const Velocity>())
+        // Added<T>/Changed<T> filters pass components added/changed after since tick
+        template <typename... TComponents>
+        [[nodiscard]] ecs::View<TComponents...> View(const tick since = 0) {
+            signature mask{};
+            (mask.set(GetComponentTypeIndex<query_component_t<TComponents>>()), ...);
+            return ecs::View<TComponents...>{_signatures.data(), mask, GetPool<query_component_t<TComponents>>()..., since};
+        }
+
+    public: // Groups
+
+        // Persistent owning group, updated on every insert/remove of owned components.
+        // Owned pools are reordered, so each component can be owned only by one group
+        template <typename... TComponents>
+        [[nodiscard]] ecs::Group<TComponents...>& Group() {
+            type_index group_type = TypeIndexator<ecs::Group<TComponents...>>::value();
+            auto found = _groups.find(group_type);
+            if (found != _groups.end())
+                return *static_cast<ecs::Group<TComponents...>*>(found->second.get());
+
+            assert(((_component_groups[GetComponentTypeIndex<TComponents>()] == nullptr) && ...) 
+                && "Component already owned by other group");
+
+            auto group = std::make_unique<ecs::Group<TComponents...>>(GetPool<TComponents>()...);
+            auto& result = *group;
+            ((_component_groups[GetComponentTypeIndex<TComponents>()] = group.get()), ...);
+            _groups.insert_or_assign(group_type, std::move(group));
+            return result;
+        }
+
+    public: // Command Buffers
+
+        void Flush(CommandBuffer& buffer) {
+            CommandBuffer* buffers[] = { &buffer };
+            Flush(buffers);
+        }
+
+        // Applies and clears buffers. Commands are sorted: creates, then inserts/removes grouped by component type
+        // (in recorded order inside one type), then destroys. Commands for not existing entities are skipped
+        void Flush(std::span<CommandBuffer* const> buffers) {
+            _flush_commands.clear();
+            _flush_created.clear();
+            _flush_created_offsets.clear();
+
+            for (uint32_t buffer = 0; buffer < buffers.size(); buffer++) {
+                const auto& commands = buffers[buffer]->_commands;
+                _flush_created_offsets.push_back(_flush_created.size());
+                for (uint32_t command = 0; command < commands.size(); command++) {
+                    auto type = commands[command].type;
+                    if (type == CommandBuffer::CommandType::Create) {
+                        _flush_created.push_back(CreateEntity());
+                        continue;
+                    }
+                    uint64_t phase = type == CommandBuffer::CommandType::Destroy ? 2 : 1;
+                    _flush_commands.push_back(FlushCommand{(phase << 32) | commands[command].component_type, buffer, command});
+                }
+            }
+            std::stable_sort(_flush_commands.begin(), _flush_commands.end(),
+                [](const FlushCommand& a, const FlushCommand& b) { return a.key < b.key; });
+
+            for (auto& flush_command : _flush_commands) {
+                auto& command = buffers[flush_command.buffer]->_commands[flush_command.command];
+                entity entity = command.entity;
+                if (CommandBuffer::IsPending(entity))
+                    entity = _flush_created[_flush_created_offsets[flush_command.buffer] + GetEntityIndex(entity)];
+                if (!ExistsEntity(entity)) continue;
+
+                if (command.type == CommandBuffer::CommandType::Destroy)
+                    DestroyEntity(entity);
+                else
+                    command.apply(*this, entity, command.payload);
+            }
+
+            for (auto buffer : buffers) buffer->clear();
+            FlushEvents();
+        }
+
+        // entities created by last Flush, in order of buffers and their create commands
+        [[nodiscard]] std::span<const entity> GetFlushCreated() const { return _flush_created; }
+
+    public: // Sorting
+
+        // Sorts pool of TComponent with compare(const TComponent&, const TComponent&) or compare(entity, entity).
+        // Pool owned by group is sorted in two ranges: members of group, whose swaps are applied to all owned pools,
+        // so group stays aligned, and entities after them
+        template <typename TComponent, typename Compare>
+        void Sort(Compare compare, const SortAlgorithm algorithm = SortAlgorithm::Full) {
+            auto pool = GetPool<TComponent>();
+            auto group = _component_groups[GetComponentTypeIndex<TComponent>()];
+            const size_t members = group ? group->size() : 0;
+            auto less = PoolLess(std::as_const(*pool), compare);
+            if (group) SortIndexes(0, members, less, [group](const size_t a, const size_t b) { group->SwapAt(a, b); }, algorithm);
+            SortIndexes(members, pool->size(), less, [pool](const size_t a, const size_t b) { pool->SwapIndexes(a, b); }, algorithm);
+        }
+        // Orders pool of TComponent as pool of TOther (lead of view), so view over them walks both pools forward.
+        // Group members of owned pool are ordered inside group range, as in Sort
+        template <typename TComponent, typename TOther>
+        void SortAs() {
+            auto pool = GetPool<TComponent>();
+            auto other = GetPool<TOther>();
+            auto group = _component_groups[GetComponentTypeIndex<TComponent>()];
+            const size_t members = group ? group->size() : 0;
+            if (group) SortIndexesAs(*pool, *other, 0, members, [group](const size_t a, const size_t b) { group->SwapAt(a, b); });
+            SortIndexesAs(*pool, *other, members, pool->size(), [pool](const size_t a, const size_t b) { pool->SwapIndexes(a, b); });
+        }
+
+    public: // Hierarchy
+
+        // Detaches child from its parent and attaches it to parent, NULL_ENTITY parent makes child root.
+        // Both get Hierarchy component if they don't have it. O(1), but pool order is sorted by SortHierarchy
+        void SetParent(const entity child, const entity parent) {
+            assert_created_entity(child);
+            assert((parent == NULL_ENTITY || ExistsEntity(parent)) && "Parent doesn't created or already destroyed");
+            if (!IsRegistered<Hierarchy>()) RegisterComponent<Hierarchy>();
+            if (!IsHierarchyNode(child)) InsertComponent(child, Hierarchy{});
+            Unlink(child);
+            if (parent == NULL_ENTITY) return;
+            if (!IsHierarchyNode(parent)) InsertComponent(parent, Hierarchy{});
+            assert(!IsDescendant(parent, child) && "Entity can't be attached to its subtree");
+
+            auto pool = HierarchyPool();
+            Hierarchy& node = pool->GetComponent(child);
+            Hierarchy& parent_node = pool->GetComponent(parent);
+            node.parent = parent;
+            node.next_sibling = parent_node.first_child;
+            if (parent_node.first_child != NULL_ENTITY) pool->GetComponent(parent_node.first_child).prev_sibling = child;
+            parent_node.first_child = child;
+            parent_node.children++;
+        }
+        // NULL_ENTITY for roots and entities out of hierarchy
+        [[nodiscard]] entity GetParent(const entity entity) const {
+            return IsHierarchyNode(entity) ? std::as_const(*HierarchyPool())[entity].parent : NULL_ENTITY;
+        }
+        // Detaches entity from its parent and its children, children become roots. O(children)
+        void Detach(const entity entity) {
+            if (!IsHierarchyNode(entity)) return;
+            Unlink(entity);
+            auto pool = HierarchyPool();
+            Hierarchy& node = pool->GetComponent(entity);
+            for (ecs::entity child = node.first_child; child != NULL_ENTITY;) {
+                Hierarchy& child_node = pool->GetComponent(child);
+                child = std::exchange(child_node.next_sibling, NULL_ENTITY);
+                child_node.parent = NULL_ENTITY;
+                child_node.prev_sibling = NULL_ENTITY;
+            }
+            node.first_child = NULL_ENTITY;
+            node.children = 0;
+        }
+        // func(entity) for every child of parent
+        template <typename Func>
+        void EachChild(const entity parent, Func func) const {
+            if (!IsHierarchyNode(parent)) return;
+            const auto& pool = *HierarchyPool();
+            for (entity child = pool[parent].first_child; child != NULL_ENTITY; child = pool[child].next_sibling)
+                func(child);
+        }
+
+        // Reorders hierarchy pool, so every parent is before its children and propagation is one forward pass
+        // over pool. Entity of every position is swapped into place, so there are at most size - 1 swaps
+        // and already sorted pool isn't changed. Roots keep their relative order
+        void SortHierarchy(const HierarchyOrder order = HierarchyOrder::BreadthFirst) {
+            if (_hierarchy == NULL_COMPONENT) return;
+            assert(_component_groups[_hierarchy] == nullptr && "Hierarchy owned by group can't be sorted");
+            auto pool = HierarchyPool();
+            const auto& nodes = std::as_const(*pool);
+
+            _hierarchy_nodes.clear();
+            for (size_t index = 0; index < pool->size(); index++) {
+                const entity entity = pool->GetEntityAt(index);
+                if (nodes[entity].parent == NULL_ENTITY) _hierarchy_nodes.push_back(entity);
+            }
+            if (order == HierarchyOrder::BreadthFirst) {
+                for (size_t index = 0; index < _hierarchy_nodes.size(); index++) {
+                    for (entity child = nodes[_hierarchy_nodes[index]].first_child; child != NULL_ENTITY; child = nodes[child].next_sibling)
+                        _hierarchy_nodes.push_back(child);
+                }
+            }
+            else {
+                const size_t roots = _hierarchy_nodes.size();
+                for (size_t index = 0; index < roots; index++) {
+                    const entity root = _hierarchy_nodes[index];
+                    _hierarchy_nodes.push_back(root);
+                    CollectDescendants(root, _hierarchy_nodes);
+                }
+                _hierarchy_nodes.erase(_hierarchy_nodes.begin(), _hierarchy_nodes.begin() + roots);
+            }
+
+            assert(_hierarchy_nodes.size() == pool->size() && "Hierarchy has cycle or broken links");
+            for (size_t index = 0; index < _hierarchy_nodes.size(); index++)
+                pool->SwapIndexes(index, pool->GetIndex(_hierarchy_nodes[index]));
+        }
+
+    public: // Observers
+
+        // world.OnAdd<Position>([](std::span<const ecs::entity> entities) { ... }), delivered in FlushEvents
+        template <typename TComponent>
+        void OnAdd(IComponentObservers::entities_observer observer) {
+            GetOrCreateObservers<TComponent>().OnAdd(std::move(observer));
+        }
+        // component was replaced with InsertComponent or changed with Patch
+        template <typename TComponent>
+        void OnUpdate(IComponentObservers::entities_observer observer) {
+            GetOrCreateObservers<TComponent>().OnUpdate(std::move(observer));
+        }
+        // removed components are moved to observers, also called for components of destroyed entities
+        template <typename TComponent>
+        void OnRemove(typename ComponentObservers<TComponent>::remove_observer observer) {
+            GetOrCreateObservers<TComponent>().OnRemove(std::move(observer));
+        }
+
+        // func(TComponent&) and record update event
+        template <typename TComponent, typename Func>
+        void Patch(const entity entity, Func func) {
+            func(GetComponent<TComponent>(entity));
+            if (auto observers = _component_observers[GetComponentTypeIndex<TComponent>()].get())
+                observers->RecordUpdate(entity);
+        }
+
+        // delivers recorded events to observers, called at the end of Flush and system collection execution
+        void FlushEvents() {
+            for (auto& observers : _component_observers)
+                if (observers) observers->Deliver();
+        }
+
     public: // Iterators
     
-        std::unordered_map<entity, dynamic_bitset>::iterator begin_ent_active() {
+        // iterate signature matrix, row index is entity, destroyed entities have empty signature
+        std::pmr::vector<signature>::iterator begin_ent_active() {
             return _signatures.begin();
         }
-        std::unordered_map<entity, dynamic_bitset>::iterator end_ent_active() {
+        std::pmr::vector<signature>::iterator end_ent_active() {
             return _signatures.end();
         }
 
     public: // Pools
+        // Pools are owned by world and never move, so returned pointers can be cached for world lifetime
         template <typename TComponent>
-        [[nodiscard]] std::shared_ptr<ComponentPool<TComponent>> GetOrCreatePool() {
-            type_index component_type = TypeIndexator<TComponent>::value();
+        [[nodiscard]] pool_for<TComponent>* GetOrCreatePool() {
+            if (!IsRegistered<TComponent>()) RegisterComponent<TComponent>();
+            return GetPool<TComponent>();
+        }
+
+        template <typename TComponent>
+        [[nodiscard]] pool_for<TComponent>* GetPool() {
+            return static_cast<pool_for<TComponent>*>(_pools[GetComponentTypeIndex<TComponent>()].get());
+        }
+        [[nodiscard]] IComponentPool* GetPool(const type_index component_type) {
+            return _pools[GetComponentTypeIndex(component_type)].get();
+        }
+        [[nodiscard]] std::pmr::memory_resource* GetResource() const { return _resource; }
+
+    public: // Snapshots
 
-            if (_component_pools.find(component_type) == _component_pools.end()) {
-                RegisterComponent<TComponent>();
-                return _component_pools[component_type];
+        // Binary snapshot of entity table, signatures and packed arrays of pools, see snapshot.hpp.
+        // Components, which are not trivially copyable, aren't written and are missing after load
+        bool SaveSnapshot(std::ostream& out) const {
+            SnapshotWriter writer{out};
+            SnapshotHeader header{};
+            std::memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+            header.version = SNAPSHOT_VERSION;
+            header.signature_words = static_cast<uint32_t>(signature::WORDS);
+            header.entities_size = static_cast<uint32_t>(_entities.size());
+            header.entities_count = _entities_count;
+            header.free_entity = _free_entity;
+            header.current_tick = GetTick();
+            header.pools_count = static_cast<uint32_t>(_components.size());
+            writer.Write(header);
+            writer.Align();
+
+            writer.Block(_entities.data(), _entities.size() * sizeof(entity));
+            writer.Block(_signatures.data(), _entities.size() * sizeof(signature));
+            for (auto& pool : _pools) pool->SaveSnapshot(writer);
+            return writer.Good();
+        }
+        bool SaveSnapshot(const std::string& path) const {
+            std::ofstream file{path, std::ios::binary};
+            return file && SaveSnapshot(file);
+        }
+
+        // Replaces entities and components with snapshot. Components of snapshot must be registered,
+        // in any order. Whole snapshot is validated first, so world isn't changed and false is returned,
+        // if snapshot doesn't match world or is truncated or corrupted.
+        // Entity handles stay valid, groups are rebuilt, observers aren't notified, tick never decreases
+        bool LoadSnapshot(std::span<const std::byte> bytes) {
+            ParsedSnapshot snapshot{};
+            if (!ParseSnapshot(bytes, snapshot)) return false;
+            const SnapshotHeader& header = snapshot.header;
+
+            if (header.entities_size > _entities_capacity) resize_entities(header.entities_size);
+            _entities.resize(header.entities_size);
+            if (header.entities_size > 0) std::memcpy(_entities.data(), snapshot.entities, header.entities_size * sizeof(entity));
+            _entities_count = header.entities_count;
+            _free_entity = header.free_entity;
+
+            // signature bits are component indexes of saved world, they are remapped if registration order differs
+            std::fill(_signatures.begin(), _signatures.end(), signature{});
+            if (snapshot.same_layout) {
+                if (header.entities_size > 0) std::memcpy(_signatures.data(), snapshot.signatures, header.entities_size * sizeof(signature));
             }
-            
-            std::shared_ptr<IComponentPool> componentPool = _component_pools[component_type];
-            return std::static_pointer_cast<ComponentPool<TComponent>>(componentPool);
+            else {
+                for (size_t index = 0; index < header.entities_size; index++)
+                    _signatures[index] = snapshot.GetSignature(index);
+            }
+
+            SnapshotReader reader{bytes};
+            for (auto& pool : _pools) pool->clear();
+            for (auto& pool : snapshot.pools) {
+                reader.SetOffset(pool.payload);
+                _pools[pool.index]->LoadSnapshot(pool.header, reader);
+            }
+
+            SetTickAtLeast(header.current_tick);
+            for (auto& [group_type, group] : _groups) group->Rebuild();
+            return true;
+        }
+        // file is mapped (or read on platforms without mmap), components are copied from it with bulk copies
+        bool LoadSnapshot(const std::string& path) {
+            MappedFile file{path};
+            return file.Good() && LoadSnapshot(file.GetBytes());
         }
 
-        template <typename TComponent>
-        [[nodiscard]] std::shared_ptr<ComponentPool<TComponent>> GetPool() {
-            type_index component_type = TypeIndexator<TComponent>::value();
-            std::shared_ptr<IComponentPool> componentPool = GetPool(component_type);
-            return std::static_pointer_cast<ComponentPool<TComponent>>(componentPool);
+    public: // Deltas
+
+        // Delta from base snapshot of this world to current state, see snapshot.hpp for format.
+        // Only components added or changed since tick of base are compared, so for rollback history
+        // keep keyframe snapshot and deltas against it. Components, which are not trivially copyable,
+        // aren't written. false if base doesn't match world
+        bool SaveDelta(std::span<const std::byte> base, std::ostream& out) const {
+            ParsedSnapshot snapshot{};
+            if (!ParseSnapshot(base, snapshot)) return false;
+
+            SnapshotWriter writer{out};
+            DeltaHeader header{};
+            std::memcpy(header.magic, DELTA_MAGIC, sizeof(header.magic));
+            header.version = DELTA_VERSION;
+            header.signature_words = static_cast<uint32_t>(signature::WORDS);
+            header.base_tick = snapshot.header.current_tick;
+            header.current_tick = GetTick();
+            header.entities_size = static_cast<uint32_t>(_entities.size());
+            header.entities_count = _entities_count;
+            header.free_entity = _free_entity;
+            header.pools_count = static_cast<uint32_t>(_components.size());
+
+            // slots after end of smaller table are compared with NULL_ENTITY, which is never alive
+            std::vector<DeltaSlot> slots{};
+            const size_t slots_end = std::max<size_t>(_entities.size(), snapshot.header.entities_size);
+            for (size_t index = 0; index < slots_end; index++) {
+                const entity current = index < _entities.size() ? _entities[index] : NULL_ENTITY;
+                if (current != snapshot.GetEntity(index)) slots.push_back(DeltaSlot{index, current});
+            }
+            std::vector<uint64_t> rows{};
+            for (size_t index = 0; index < _entities.size(); index++)
+                if (!(_signatures[index] == snapshot.GetSignature(index))) rows.push_back(index);
+
+            header.slots_count = static_cast<uint32_t>(slots.size());
+            header.signatures_count = static_cast<uint32_t>(rows.size());
+            writer.Write(header);
+            for (auto& slot : slots) writer.Write(slot);
+            for (auto row : rows) {
+                writer.Write(row);
+                writer.Write(_signatures[row]);
+            }
+
+            std::vector<const SnapshotPool*> base_pools(_components.size(), nullptr);
+            for (auto& pool : snapshot.pools) base_pools[pool.index] = &pool;
+
+            std::vector<std::byte> records{};
+            std::vector<std::byte> current{};
+            std::vector<std::byte> previous{};
+            std::vector<uint32_t> base_indexes{};
+            for (size_t i = 0; i < _pools.size(); i++) {
+                const auto& pool = _pools[i];
+                const SnapshotPoolHeader pool_header = pool->GetSnapshotHeader();
+                DeltaPoolHeader delta_header{pool_header.type_hash, 0, pool_header.component_size, 0, pool_header.flags, 0};
+                records.clear();
+
+                const SnapshotPool* base_pool = base_pools[i];
+                if (!(pool_header.flags & SnapshotPoolHeader::RAW)) base_pool = nullptr;
+                const std::byte* base_payload = base_pool ? base.data() + base_pool->payload : nullptr;
+                const size_t base_count = base_pool ? base_pool->header.count : 0;
+                auto base_entity = [&](const size_t index) {
+                    entity entity;
+                    std::memcpy(&entity, base_payload + index * sizeof(ecs::entity), sizeof(ecs::entity));
+                    return entity;
+                };
+                // base index of entity, components usually keep their index, so map is built only on first miss
+                base_indexes.clear();
+                auto find_base = [&](const entity entity, const size_t index) -> size_t {
+                    if (index < base_count && base_entity(index) == entity) return index;
+                    if (base_indexes.empty() && base_count > 0) {
+                        base_indexes.assign(_entities_capacity, NULL_ENTITY_INDEX);
+                        for (size_t base_index = 0; base_index < base_count; base_index++) {
+                            const entity_index entity_index = GetEntityIndex(base_entity(base_index));
+                            if (entity_index < base_indexes.size()) base_indexes[entity_index] = static_cast<uint32_t>(base_index);
+                        }
+                    }
+                    if (GetEntityIndex(entity) >= base_indexes.size()) return NULL_ENTITY_INDEX;
+                    const uint32_t base_index = base_indexes[GetEntityIndex(entity)];
+                    return base_index != NULL_ENTITY_INDEX && base_entity(base_index) == entity ? base_index : NULL_ENTITY_INDEX;
+                };
+
+                if (pool_header.flags & SnapshotPoolHeader::RAW) {
+                    current.resize(pool->GetPackedSize());
+                    previous.resize(pool->GetPackedSize());
+                    const std::span<const tick> changed = pool->GetChangedTicks();
+                    for (size_t index = 0; index < pool->size(); index++) {
+                        if (changed[index] < snapshot.header.current_tick) continue; // changes after save have the same tick
+                        const entity entity = pool->data()[index];
+                        const size_t base_index = find_base(entity, index);
+                        pool->ReadPacked(index, current.data());
+                        if (base_index != NULL_ENTITY_INDEX) pool->ReadSnapshotPacked(base_payload, base_count, base_index, previous.data());
+
+                        const size_t begin = records.size();
+                        records.resize(begin + sizeof(DeltaRecord));
+                        DeltaEncode(current, base_index != NULL_ENTITY_INDEX ? previous.data() : nullptr, records);
+                        const size_t encoded = records.size() - begin - sizeof(DeltaRecord);
+                        if (base_index != NULL_ENTITY_INDEX && encoded == 0) { // unchanged
+                            records.resize(begin);
+                            continue;
+                        }
+                        const DeltaRecord record{entity, static_cast<uint32_t>(encoded), base_index != NULL_ENTITY_INDEX};
+                        std::memcpy(records.data() + begin, &record, sizeof(DeltaRecord));
+                        delta_header.records_count++;
+                    }
+                }
+                delta_header.payload_bytes = records.size();
+                writer.Write(delta_header);
+                writer.Write(records.data(), records.size());
+            }
+            return writer.Good();
         }
-        [[nodiscard]] std::shared_ptr<IComponentPool> GetPool(const type_index& component_type) {
-            assert(_component_pools.find(component_type) != _component_pools.end() && "ComponentPool can't found, register component");
-            
-            std::shared_ptr<IComponentPool> componentPool = _component_pools[component_type];
-            return componentPool;
+
+        // Applies delta to world, which is in state of base snapshot of delta (loaded from it, or with the same history).
+        // Components of delta must be registered, in any order. World isn't changed and false is returned,
+        // if delta doesn't match world. Groups and observers are updated as for usual inserts and removes
+        bool ApplyDelta(std::span<const std::byte> delta) {
+            SnapshotReader reader{delta};
+            DeltaHeader header{};
+            if (!reader.Read(header)) return false;
+            if (std::memcmp(header.magic, DELTA_MAGIC, sizeof(header.magic)) != 0) return false;
+            if (header.version != DELTA_VERSION || header.signature_words != signature::WORDS) return false;
+            if (header.entities_count > header.entities_size) return false;
+            if (header.free_entity != NULL_ENTITY_INDEX && header.free_entity >= header.entities_size) return false;
+
+            const size_t slots_offset = reader.GetOffset();
+            if (!reader.Skip(header.slots_count * sizeof(DeltaSlot))) return false;
+            const size_t rows_offset = reader.GetOffset();
+            constexpr size_t ROW_BYTES = sizeof(uint64_t) + sizeof(signature);
+            if (!reader.Skip(header.signatures_count * ROW_BYTES)) return false;
+
+            // validate everything before anything is changed, slots and rows are sorted by index to find
+            // entity and saved signature, which records will see
+            const size_t slots_end = std::max<size_t>(header.entities_size, _entities.size());
+            std::vector<DeltaSlot> slots(header.slots_count);
+            for (size_t i = 0; i < header.slots_count; i++) {
+                std::memcpy(&slots[i], delta.data() + slots_offset + i * sizeof(DeltaSlot), sizeof(DeltaSlot));
+                if (slots[i].index >= slots_end) return false;
+            }
+            std::vector<std::pair<uint64_t, size_t>> rows(header.signatures_count); // row, offset of saved signature
+            for (size_t i = 0; i < header.signatures_count; i++) {
+                std::memcpy(&rows[i].first, delta.data() + rows_offset + i * ROW_BYTES, sizeof(uint64_t));
+                rows[i].second = rows_offset + i * ROW_BYTES + sizeof(uint64_t);
+                if (rows[i].first >= header.entities_size) return false;
+            }
+            auto by_index = [](const DeltaSlot& a, const DeltaSlot& b) { return a.index < b.index; };
+            std::sort(slots.begin(), slots.end(), by_index);
+            std::sort(rows.begin(), rows.end());
+            auto same_slot = [](const DeltaSlot& a, const DeltaSlot& b) { return a.index == b.index; };
+            auto same_row = [](const auto& a, const auto& b) { return a.first == b.first; };
+            if (std::adjacent_find(slots.begin(), slots.end(), same_slot) != slots.end()) return false;
+            if (std::adjacent_find(rows.begin(), rows.end(), same_row) != rows.end()) return false;
+
+            // record must target entity, which is alive after delta, and patch must target existing component:
+            // saved signature has bit of pool in delta, or signature of unchanged entity has pool
+            auto valid_target = [&](const entity target, const size_t delta_pool, const size_t pool_index, const bool patch) {
+                const size_t index = GetEntityIndex(target);
+                const entity current = index < _entities.size() ? _entities[index] : NULL_ENTITY;
+                auto slot = std::lower_bound(slots.begin(), slots.end(), DeltaSlot{index, NULL_ENTITY}, by_index);
+                const bool replaced = slot != slots.end() && slot->index == index;
+                if (target != (replaced ? slot->slot : current)) return false;
+                if (!patch) return true;
+
+                auto row = std::lower_bound(rows.begin(), rows.end(), std::pair<uint64_t, size_t>{index, 0});
+                if (row != rows.end() && row->first == index) {
+                    signature saved{};
+                    std::memcpy(&saved, delta.data() + row->second, sizeof(signature));
+                    return delta_pool < signature::CAPACITY && saved.get(delta_pool);
+                }
+                return (!replaced || slot->slot == current) && _signatures[index].get(pool_index);
+            };
+
+            struct DeltaPool {
+                DeltaPoolHeader header;
+                size_t index; // in this world
+                size_t records;
+            };
+            if (header.pools_count > (delta.size() - reader.GetOffset()) / sizeof(DeltaPoolHeader)) return false;
+            std::vector<DeltaPool> pools(header.pools_count);
+            std::vector<std::byte> mask{};
+            signature keep{}; // bits of components, which aren't in delta
+            for (size_t i = 0; i < _components.size(); i++) keep.set(i);
+            for (size_t delta_pool = 0; delta_pool < pools.size(); delta_pool++) {
+                DeltaPool& pool = pools[delta_pool];
+                if (!reader.Read(pool.header)) return false;
+                const SnapshotPoolHeader pool_header{pool.header.type_hash, 0, pool.header.component_size, 0, pool.header.flags, 0};
+                auto found = std::find_if(_pools.begin(), _pools.end(), [&](const auto& world_pool) {
+                    return world_pool->CanLoadSnapshot(pool_header);
+                });
+                if (found == _pools.end()) return false;
+                pool.index = static_cast<size_t>(found - _pools.begin());
+                pool.records = reader.GetOffset();
+                if (pool.header.flags & SnapshotPoolHeader::RAW) keep.set(pool.index, false);
+
+                mask.resize((*found)->GetPackedSize());
+                for (size_t record = 0; record < pool.header.records_count; record++) {
+                    DeltaRecord delta_record{};
+                    if (!reader.Read(delta_record) || GetEntityIndex(delta_record.target) >= header.entities_size) return false;
+                    if (delta_record.patch && !(pool.header.flags & SnapshotPoolHeader::RAW)) return false;
+                    if (!valid_target(delta_record.target, delta_pool, pool.index, delta_record.patch != 0)) return false;
+                    const size_t encoded = reader.GetOffset();
+                    if (!reader.Skip(delta_record.bytes)) return false;
+                    if (!DeltaDecode(delta.subspan(encoded, delta_record.bytes), mask)) return false;
+                }
+                if (reader.GetOffset() - pool.records != pool.header.payload_bytes) return false;
+            }
+
+            // destroyed entities lose their components, then entity table is replaced
+            for (size_t i = 0; i < header.slots_count; i++) {
+                DeltaSlot slot{};
+                std::memcpy(&slot, delta.data() + slots_offset + i * sizeof(DeltaSlot), sizeof(DeltaSlot));
+                if (slot.index >= _entities.size()) continue;
+                const entity current = _entities[slot.index];
+                if (GetEntityIndex(current) != slot.index || current == slot.slot) continue;
+                RemoveAllComponents(current);
+                _signatures[slot.index].reset();
+            }
+            if (header.entities_size > _entities_capacity) resize_entities(header.entities_size);
+            _entities.resize(header.entities_size);
+            for (size_t i = 0; i < header.slots_count; i++) {
+                DeltaSlot slot{};
+                std::memcpy(&slot, delta.data() + slots_offset + i * sizeof(DeltaSlot), sizeof(DeltaSlot));
+                if (slot.index < header.entities_size) _entities[slot.index] = slot.slot;
+            }
+            _entities_count = header.entities_count;
+            _free_entity = header.free_entity;
+
+            // signature bits are component indexes of saved world, removed bits remove components now,
+            // added bits are filled by records
+            for (size_t i = 0; i < header.signatures_count; i++) {
+                uint64_t row = 0;
+                signature saved{};
+                std::memcpy(&row, delta.data() + rows_offset + i * ROW_BYTES, sizeof(row));
+                std::memcpy(&saved, delta.data() + rows_offset + i * ROW_BYTES + sizeof(row), sizeof(signature));
+
+                signature next = _signatures[row];
+                next &= keep;
+                for (size_t bit = saved.find_first(); bit != signature::npos; bit = saved.find_next(bit))
+                    if (bit < pools.size() && (pools[bit].header.flags & SnapshotPoolHeader::RAW)) next.set(pools[bit].index);
+
+                const entity entity = _entities[row];
+                if (GetEntityIndex(entity) == row) {
+                    signature removed = _signatures[row];
+                    removed -= next;
+                    for (size_t bit = removed.find_first(); bit != signature::npos; bit = removed.find_next(bit))
+                        RemoveComponent(entity, bit);
+                }
+                _signatures[row] = next;
+            }
+
+            for (auto& pool : pools) {
+                auto& component_pool = _pools[pool.index];
+                auto group = _component_groups[pool.index];
+                auto observers = _component_observers[pool.index].get();
+                mask.resize(component_pool->GetPackedSize());
+                reader.SetOffset(pool.records);
+                for (size_t record = 0; record < pool.header.records_count; record++) {
+                    DeltaRecord delta_record{};
+                    (void)reader.Read(delta_record);
+                    (void)DeltaDecode(delta.subspan(reader.GetOffset(), delta_record.bytes), mask);
+                    (void)reader.Skip(delta_record.bytes);
+
+                    component_pool->ApplyPacked(delta_record.target, mask.data(), delta_record.patch != 0);
+                    if (delta_record.patch) {
+                        if (observers) observers->RecordUpdate(delta_record.target);
+                        continue;
+                    }
+                    if (observers) observers->RecordAdd(delta_record.target);
+                    if (group) group->OnInsert(delta_record.target);
+                }
+            }
+
+            SetTickAtLeast(header.current_tick);
+            return true;
+        }
+
+    public: // Stats
+
+        // memory of entity table, signatures and pools, doesn't include maps of registry, groups and observers
+        [[nodiscard]] WorldStats Stats() const {
+            WorldStats stats{};
+            stats.entities_count = _entities_count;
+            stats.entities_capacity = _entities_capacity;
+            stats.free_entities = _entities.size() - _entities_count;
+            stats.fragmentation = _entities.empty() ? 0.0 : static_cast<double>(stats.free_entities) / _entities.size();
+            stats.signature_bytes = _signatures.capacity() * sizeof(signature);
+            stats.entity_table_bytes = _entities.capacity() * sizeof(entity);
+            stats.used_bytes = (_entities.size() * sizeof(entity)) + (_signatures.size() * sizeof(signature));
+            stats.reserved_bytes = stats.signature_bytes + stats.entity_table_bytes;
+
+            stats.pools.reserve(_components.size());
+            for (size_t i = 0; i < _pools.size(); i++) {
+                PoolStats pool = _pools[i]->MemoryStats();
+                stats.used_bytes += pool.used_bytes;
+                stats.reserved_bytes += pool.reserved_bytes;
+                stats.pools.emplace_back(_components[i], pool);
+            }
+            return stats;
+        }
+
+    public: // Ticks
+
+        [[nodiscard]] tick GetTick() const { return _tick.load(std::memory_order_relaxed); }
+        // components inserted/changed after advance are stamped with new tick, returns new tick.
+        // Systems advance tick after every system run, so can be called concurrently
+        tick AdvanceTick() {
+            const tick tick = _tick.fetch_add(1, std::memory_order_relaxed) + 1;
+            for (const auto& pool : _pools) pool->SetTick(tick);
+            return tick;
         }
 
     public: // Data Modification
         void resize_entities(uint32_t new_size) {
             if (new_size == _entities_capacity) return;
 
-            if (_entities_capacity < new_size) {
-                for (entity entity = _entities_capacity; entity < new_size; entity++) {
-                    _available_entities.insert(entity);
-                }
-            }
-            else {
-                for (entity entity = new_size - 1; entity >= _entities_capacity; entity--) {
-                    assert(_available_entities.contains(entity) && "Can't erase created entities");
-                    _available_entities.erase(entity);
+            if (new_size < _entities.size()) { // drop free slots after new_size and rebuild free list
+                _free_entity = NULL_ENTITY_INDEX;
+                for (entity_index index = static_cast<entity_index>(_entities.size()); index-- > 0; ) {
+                    const entity slot = _entities[index];
+                    if (GetEntityIndex(slot) == index) { // alive
+                        assert(index < new_size && "Can't erase created entities");
+                        continue;
+                    }
+                    if (index >= new_size) continue;
+                    _entities[index] = MakeEntity(_free_entity, GetEntityVersion(slot));
+                    _free_entity = index;
                 }
+                _entities.resize(new_size);
             }
             
+            _signatures.resize(new_size);
+            for (auto& pool : _pools) {
+                pool->resize(new_size);
+            }
             _entities_capacity = new_size;
         }
         void resize_entity(uint32_t new_size) {
-            if (new_size == _entities_capacity) return;
-
-            for (auto it = _signatures.begin(); it != _signatures.end(); it++) {
-                auto& pair = *it;
-                pair.second.resize(new_size);
-            }
+            if (new_size == _entity_capacity) return;
+            assert(new_size <= signature::CAPACITY && "Signature is too small, increase YAECS_SIGNATURE_WORDS");
+            assert(_components.size() <= new_size && "New capacity will erase registered components");
 
             _entity_capacity = new_size;
         }
         void reserve_component_pools(uint32_t new_capacity) {
             if (new_capacity == _pools_capacity) return;
-            assert(_component_pools.size() <= new_capacity && "New capacity will erase registered components");
+            assert(_pools.size() <= new_capacity && "New capacity will erase registered components");
 
-            _component_pools.reserve(new_capacity);
-            _component_indexes.reserve(new_capacity);
             _components.reserve(new_capacity);
+            _pools.reserve(new_capacity);
+            _component_groups.reserve(new_capacity);
+            _component_observers.reserve(new_capacity);
             _pools_capacity = new_capacity;
         }
 
+    private: // Helpers
+
+        [[nodiscard]] pool_for<Hierarchy>* HierarchyPool() const {
+            return static_cast<pool_for<Hierarchy>*>(_pools[_hierarchy].get());
+        }
+        [[nodiscard]] bool IsHierarchyNode(const entity entity) const {
+            return _hierarchy != NULL_COMPONENT && _signatures[GetEntityIndex(entity)].get(_hierarchy);
+        }
+        [[nodiscard]] bool IsDescendant(entity node, const entity ancestor) const {
+            const auto& pool = std::as_const(*HierarchyPool());
+            for (; node != NULL_ENTITY; node = pool[node].parent)
+                if (node == ancestor) return true;
+            return false;
+        }
+        // detaches node from parent and siblings, its subtree stays attached to it
+        void Unlink(const entity entity) {
+            auto pool = HierarchyPool();
+            Hierarchy& node = pool->GetComponent(entity);
+            if (node.parent == NULL_ENTITY) return;
+            Hierarchy& parent_node = pool->GetComponent(node.parent);
+            if (node.prev_sibling != NULL_ENTITY) pool->GetComponent(node.prev_sibling).next_sibling = node.next_sibling;
+            else parent_node.first_child = node.next_sibling;
+            if (node.next_sibling != NULL_ENTITY) pool->GetComponent(node.next_sibling).prev_sibling = node.prev_sibling;
+            parent_node.children--;
+            node.parent = NULL_ENTITY;
+            node.prev_sibling = NULL_ENTITY;
+            node.next_sibling = NULL_ENTITY;
+        }
+        // pre-order walk of subtree without root, links are followed, so there is no stack
+        void CollectDescendants(const entity root, std::vector<entity>& out) const {
+            const auto& pool = std::as_const(*HierarchyPool());
+            entity node = pool[root].first_child;
+            while (node != NULL_ENTITY) {
+                out.push_back(node);
+                if (pool[node].first_child != NULL_ENTITY) {
+                    node = pool[node].first_child;
+                    continue;
+                }
+                while (node != root && pool[node].next_sibling == NULL_ENTITY) node = pool[node].parent;
+                node = node == root ? NULL_ENTITY : pool[node].next_sibling;
+            }
+        }
+
+        // removes component of registered index from pool, signature isn't changed
+        void RemoveComponent(const entity entity, const size_t index) {
+            if (auto group = _component_groups[index]) group->OnRemove(entity);
+            auto pool = _pools[index].get();
+            if (auto observers = _component_observers[index].get()) observers->RecordRemove(entity, *pool);
+            pool->RemoveComponent(entity);
+        }
+
+        struct SnapshotPool {
+            SnapshotPoolHeader header;
+            size_t index; // in this world
+            size_t payload;
+        };
+        struct ParsedSnapshot {
+            SnapshotHeader header;
+            const std::byte* entities;
+            const std::byte* signatures;
+            std::vector<SnapshotPool> pools;
+            bool same_layout; // pools are in registration order of world, signatures can be copied
+
+            [[nodiscard]] entity GetEntity(const size_t index) const {
+                entity entity = NULL_ENTITY;
+                if (index < header.entities_size) std::memcpy(&entity, entities + index * sizeof(ecs::entity), sizeof(ecs::entity));
+                return entity;
+            }
+            // signature with bits of world component indexes, components which weren't written are dropped
+            [[nodiscard]] signature GetSignature(const size_t index) const {
+                signature saved{};
+                if (index >= header.entities_size) return saved;
+                std::memcpy(&saved, signatures + index * sizeof(signature), sizeof(signature));
+                if (same_layout) return saved;
+
+                signature result{};
+                for (size_t bit = saved.find_first(); bit != signature::npos; bit = saved.find_next(bit)) {
+                    if (bit >= pools.size() || !(pools[bit].header.flags & SnapshotPoolHeader::RAW)) continue;
+                    result.set(pools[bit].index);
+                }
+                return result;
+            }
+        };
+        // validates snapshot and maps its pools to registered pools, so loading it can't fail:
+        // free list and alive count match entity table, every registered pool is loaded at most once,
+        // payloads fit components of header count and their entities are alive in entity table
+        [[nodiscard]] bool ParseSnapshot(std::span<const std::byte> bytes, ParsedSnapshot& snapshot) const {
+            SnapshotReader reader{bytes};
+            SnapshotHeader& header = snapshot.header;
+            if (!reader.Read(header)) return false;
+            if (std::memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic)) != 0) return false;
+            if (header.version != SNAPSHOT_VERSION || header.signature_words != signature::WORDS) return false;
+            if (header.entities_count > header.entities_size) return false;
+            if (header.free_entity != NULL_ENTITY_INDEX && header.free_entity >= header.entities_size) return false;
+
+            snapshot.entities = reader.Block(header.entities_size * sizeof(entity));
+            snapshot.signatures = reader.Block(header.entities_size * sizeof(signature));
+            if (!snapshot.entities || !snapshot.signatures) return false;
+
+            size_t alive = 0;
+            for (size_t index = 0; index < header.entities_size; index++)
+                if (GetEntityIndex(snapshot.GetEntity(index)) == index) alive++;
+            if (alive != header.entities_count) return false;
+            size_t free = 0;
+            for (entity_index index = header.free_entity; index != NULL_ENTITY_INDEX; free++) {
+                if (index >= header.entities_size || free == header.entities_size - alive) return false;
+                const entity_index next = GetEntityIndex(snapshot.GetEntity(index));
+                if (next == index) return false;
+                index = next;
+            }
+            if (free != header.entities_size - alive) return false;
+
+            // components of every pool, only alive entities have them
+            if (header.pools_count > signature::CAPACITY) return false;
+            if (header.pools_count > (bytes.size() - reader.GetOffset()) / sizeof(SnapshotPoolHeader)) return false;
+            std::vector<size_t> components(header.pools_count, 0);
+            for (size_t index = 0; index < header.entities_size; index++) {
+                signature saved{};
+                std::memcpy(&saved, snapshot.signatures + index * sizeof(signature), sizeof(signature));
+                if (saved.find_first() == signature::npos) continue;
+                if (GetEntityIndex(snapshot.GetEntity(index)) != index) return false;
+                for (size_t bit = saved.find_first(); bit != signature::npos; bit = saved.find_next(bit)) {
+                    if (bit >= components.size()) return false;
+                    components[bit]++;
+                }
+            }
+
+            auto& pools = snapshot.pools;
+            pools.resize(header.pools_count);
+            std::vector<uint32_t> last_pool(header.entities_size, NULL_ENTITY_INDEX); // last pool of entity, finds duplicates
+            snapshot.same_layout = header.pools_count <= _components.size();
+            for (size_t i = 0; i < pools.size(); i++) {
+                if (!reader.Read(pools[i].header)) return false;
+                auto found = std::find_if(_pools.begin(), _pools.end(), [&](const auto& pool) {
+                    return pool->CanLoadSnapshot(pools[i].header);
+                });
+                if (found == _pools.end()) return false;
+                pools[i].index = static_cast<size_t>(found - _pools.begin());
+                for (size_t j = 0; j < i; j++)
+                    if (pools[j].index == pools[i].index) return false;
+                pools[i].payload = SnapshotAligned(reader.GetOffset());
+                if (pools[i].payload > bytes.size() || pools[i].header.payload_bytes > bytes.size() - pools[i].payload) return false;
+
+                const size_t count = pools[i].header.count;
+                const size_t payload_bytes = (*found)->GetSnapshotPayloadBytes(count);
+                if (payload_bytes > pools[i].header.payload_bytes) return false;
+                if (payload_bytes > 0 && count != components[i]) return false;
+                for (size_t index = 0; payload_bytes > 0 && index < count; index++) {
+                    entity entity;
+                    std::memcpy(&entity, bytes.data() + pools[i].payload + index * sizeof(ecs::entity), sizeof(ecs::entity));
+                    if (entity == NULL_ENTITY || snapshot.GetEntity(GetEntityIndex(entity)) != entity) return false;
+                    signature saved{};
+                    std::memcpy(&saved, snapshot.signatures + GetEntityIndex(entity) * sizeof(signature), sizeof(signature));
+                    if (!saved.get(i) || last_pool[GetEntityIndex(entity)] == i) return false;
+                    last_pool[GetEntityIndex(entity)] = static_cast<uint32_t>(i);
+                }
+                reader.SetOffset(pools[i].payload + pools[i].header.payload_bytes);
+                snapshot.same_layout = snapshot.same_layout && pools[i].index == i && (pools[i].header.flags & SnapshotPoolHeader::RAW);
+            }
+            return true;
+        }
+
+        void SetTickAtLeast(const tick tick) {
+            ecs::tick current = _tick.load(std::memory_order_relaxed);
+            while (current < tick && !_tick.compare_exchange_weak(current, tick, std::memory_order_relaxed)) {}
+            for (const auto& pool : _pools) pool->SetTick(GetTick());
+        }
+
+        template <typename TComponent>
+        ComponentObservers<TComponent>& GetOrCreateObservers() {
+            auto& observers = _component_observers[GetComponentTypeIndex<TComponent>()];
+            if (!observers) observers = std::make_unique<ComponentObservers<TComponent>>();
+            return static_cast<ComponentObservers<TComponent>&>(*observers);
+        }
+
+        void ReleaseEntity(const entity entity) {
+            entity_index index = GetEntityIndex(entity);
+            _signatures[index].reset();
+            _entities[index] = MakeEntity(_free_entity, GetEntityVersion(entity) + 1);
+            _free_entity = index;
+            
+            _entities_count--;
+        }
+
+        void SetSignatures(std::span<const entity> entities, const size_t index) {
+            auto observers = _component_observers[index].get();
+            for (auto entity : entities) {
+                assert_created_entity(entity);
+                signature& signature = _signatures[GetEntityIndex(entity)];
+                if (observers) signature.get(index) ? observers->RecordUpdate(entity) : observers->RecordAdd(entity);
+                signature.set(index, true);
+            }
+            if (auto group = _component_groups[index]) {
+                for (auto entity : entities) group->OnInsert(entity);
+            }
+        }
+
     private: // Data
         uint32_t _entities_capacity = 0;
         uint32_t _entity_capacity = 0;
         uint32_t _pools_capacity = 0;
 
-        std::unordered_map<entity, dynamic_bitset> _signatures;
-        std::set<entity> _available_entities;
+        std::pmr::memory_resource* _resource;
+        std::atomic<tick> _tick{1}; // tick 0 is before everything
+        std::pmr::vector<signature> _signatures; // signature matrix, indexed by entity index
+        std::pmr::vector<entity> _entities; // alive entities and implicit free list
+        entity_index _free_entity = NULL_ENTITY_INDEX; // head of free list
         uint32_t _entities_count = 0;
 
-        std::unordered_map<type_index, std::shared_ptr<IComponentPool>> _component_pools;
-        std::unordered_map<type_index, size_t> _component_indexes;
-        std::vector<type_index> _components;
+        // pools are allocated from resource, deleter returns them there
+        struct PoolDeleter {
+            void (*destroy)(std::pmr::memory_resource* resource, IComponentPool* pool);
+            std::pmr::memory_resource* resource;
+
+            void operator()(IComponentPool* pool) const { destroy(resource, pool); }
+        };
+        template <typename TPool>
+        static void DeletePool(std::pmr::memory_resource* resource, IComponentPool* pool) {
+            std::pmr::polymorphic_allocator<>{resource}.delete_object(static_cast<TPool*>(pool));
+        }
+
+        static constexpr component_index NULL_COMPONENT = ~component_index{0};
+
+        std::vector<component_index> _component_ids; // component index by global type index, NULL_COMPONENT if not registered
+        std::vector<type_index> _components; // global type index by component index
+        std::vector<std::unique_ptr<IComponentPool, PoolDeleter>> _pools; // by component index
+
+        struct FlushCommand {
+            uint64_t key; // phase and component type
+            uint32_t buffer;
+            uint32_t command;
+        };
+        std::vector<FlushCommand> _flush_commands;
+        std::vector<entity> _flush_created;
+        std::vector<size_t> _flush_created_offsets;
+
+        std::unordered_map<type_index, std::unique_ptr<IGroup>> _groups;
+        std::vector<IGroup*> _component_groups; // owner group by component index
+        std::vector<std::unique_ptr<IComponentObservers>> _component_observers; // by component index, null if not observed
+
+        component_index _hierarchy = NULL_COMPONENT; // index of Hierarchy component
+        std::vector<entity> _hierarchy_nodes; // order of sort and subtrees of destroy
     };
 }
\ No newline at end of file
@@ -2,6 +2,15 @@
 #include "ecs.hpp"
 
 #include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <span>
+#include <memory_resource>
+#include <memory>
+#include <cstdio>
+#include <cstddef>
+#include <cstring>
 
 #define EXPECT_EQ(item1, item2) assert(item1 == item2 && "Items is not equals");
 
@@ -14,6 +23,21 @@ struct Position {
         : x{x}, y{y}, z{z} { }
 };
 
+struct Velocity {
+    float x, y, z;
+};
+
+struct Particle {
+    float x, y, z;
+};
+YAECS_SOA(Particle, &Particle::x, &Particle::y, &Particle::z);
+
+struct Name {
+    std::string value;
+};
+
+struct Dead {};
+
 class PositionSystem : public ecs::BaseSystem<Position> {
 public:
     void run() override {
@@ -26,6 +50,46 @@ public:
     }
 };
 
+class SetPositionSystem : public ecs::BaseSystem<Position> {
+public:
+    void run() override {
+        for (auto it = _pool->begin_comp_active(); it != _pool->end_comp_active(); ++it) it->x = 1;
+    }
+};
+class ScaleVelocitySystem : public ecs::BaseSystem<Velocity> {
+public:
+    void run() override {
+        for (auto it = _pool->begin_comp_active(); it != _pool->end_comp_active(); ++it) it->x *= 2;
+        AddProcessed(_pool->size());
+    }
+};
+class ScalePositionSystem : public ecs::BaseSystem<Position, ecs::Read<Velocity>> {
+public:
+    void run() override {
+        for (auto [position, velocity] : world().View<Position, const Velocity>()) position.x *= 10 * velocity.x;
+    }
+};
+
+class MovedCountSystem : public ecs::BaseSystem<Position> {
+public:
+    void run() override {
+        moved = 0;
+        world().View<ecs::Changed<const Position>>(last_run_tick()).Each([this](const Position&) { moved++; });
+    }
+    size_t moved = 0;
+};
+
+class SpawnSystem : public ecs::BaseSystem<Velocity> {
+public:
+    void run() override {
+        for (auto it = _pool->begin_ent_active(); it != _pool->end_ent_active(); ++it) {
+            ecs::entity spawned = commands().CreateEntity();
+            commands().InsertComponent(spawned, Position(1, 1, 1));
+            commands().DestroyEntity(*it);
+        }
+    }
+};
+
 
 int main(int argc, char* argv[]) {
 
@@ -37,6 +101,53 @@ int main(int argc, char* argv[]) {
     EXPECT_EQ(1, b_type);
     EXPECT_EQ(1, ecs::TypeIndexator<B>::value());
 
+    // Dynamic Bitset
+
+    ecs::dynamic_bitset bits{130};
+    bits.set(3);
+    bits.set(64);
+    bits.set(129);
+    EXPECT_EQ(3, bits.count());
+    EXPECT_EQ(3, bits.find_first());
+    EXPECT_EQ(64, bits.find_next(3));
+    EXPECT_EQ(129, bits.find_next(64));
+    EXPECT_EQ(ecs::dynamic_bitset::npos, bits.find_next(129));
+    EXPECT_EQ(true, bits.any(60, 70));
+    EXPECT_EQ(false, bits.any(4, 64));
+    EXPECT_EQ(true, bits.all(4, 64, false));
+
+    ecs::dynamic_bitset mask{130};
+    mask.set(3);
+    mask.set(129);
+    EXPECT_EQ(true, mask.is_subset_of(bits));
+    EXPECT_EQ(false, bits.is_subset_of(mask));
+    EXPECT_EQ(true, mask.intersects(bits));
+    bits -= mask;
+    EXPECT_EQ(1, bits.count());
+    EXPECT_EQ(false, mask.intersects(bits));
+    bits |= mask;
+    bits &= mask;
+    EXPECT_EQ(true, (bits == mask));
+
+    ecs::dynamic_bitset filled{70, true};
+    EXPECT_EQ(70, filled.count());
+    filled.resize(130, true);
+    EXPECT_EQ(true, filled.all());
+    filled.resize(65);
+    EXPECT_EQ(65, filled.count());
+
+    ecs::signature signature_mask{};
+    signature_mask.set(1);
+    signature_mask.set(100);
+    ecs::signature signature_full = signature_mask;
+    signature_full.set(64);
+    EXPECT_EQ(true, signature_mask.is_subset_of(signature_full));
+    EXPECT_EQ(false, signature_full.is_subset_of(signature_mask));
+    EXPECT_EQ(64, signature_full.find_next(1));
+    EXPECT_EQ(3, signature_full.count());
+    signature_full -= signature_mask;
+    EXPECT_EQ(false, signature_full.intersects(signature_mask));
+
     // World
     
     ecs::World world{3, 2};
@@ -49,6 +160,16 @@ int main(int argc, char* argv[]) {
     EXPECT_EQ(true, world.ExistsEntity(entity1));
     EXPECT_EQ(false, world.ExistsEntity(3));
 
+    ecs::World recycle_world{4, 2};
+    ecs::entity stale = recycle_world.CreateEntity();
+    recycle_world.DestroyEntity(stale);
+    ecs::entity recycled = recycle_world.CreateEntity();
+    EXPECT_EQ(ecs::GetEntityIndex(stale), ecs::GetEntityIndex(recycled));
+    EXPECT_EQ(1, ecs::GetEntityVersion(recycled));
+    EXPECT_EQ(false, recycle_world.ExistsEntity(stale));
+    EXPECT_EQ(true, recycle_world.ExistsEntity(recycled));
+    EXPECT_EQ(1, recycle_world.GetEntitiesCount());
+
     world.RegisterComponent<A>();
     //world.RegisterComponent<B>();
     world.RegisterComponent<Position>();
@@ -66,6 +187,934 @@ int main(int argc, char* argv[]) {
     EXPECT_EQ(false, signature2.get(0));
     EXPECT_EQ(true, signature2.get(1));
 
+    // component indexes are dense per world, pools are stable
+    ecs::World registry_world{4, 4};
+    registry_world.RegisterComponent<Position>();
+    auto registry_pool = registry_world.GetPool<Position>();
+    EXPECT_EQ(false, registry_world.IsRegistered<A>());
+    EXPECT_EQ(false, (registry_world.GetOrCreatePool<A>() == nullptr));
+    EXPECT_EQ(true, registry_world.IsRegistered<A>());
+    EXPECT_EQ(0, registry_world.GetComponentTypeIndex<Position>());
+    EXPECT_EQ(1, registry_world.GetComponentTypeIndex<A>());
+    EXPECT_EQ(1, world.GetComponentTypeIndex<Position>());
+    EXPECT_EQ(registry_pool, registry_world.GetPool<Position>());
+
+    // Component Pool
+
+    ecs::ComponentPool<Position> pool{8};
+    pool.InsertComponent(1, Position(1, 0, 0));
+    pool.InsertComponent(4, Position(4, 0, 0));
+    pool.InsertComponent(6, Position(6, 0, 0));
+    pool.RemoveComponent(1); // last moved into the hole
+    EXPECT_EQ(2, pool.size());
+    EXPECT_EQ(false, pool.ContainsComponent(1));
+    EXPECT_EQ(6, *pool.begin_ent_active());
+    EXPECT_EQ(6, pool.GetComponent(6).x);
+    EXPECT_EQ(4, pool.GetComponent(4).x);
+    pool.InsertComponent(4, Position(5, 0, 0)); // replace
+    EXPECT_EQ(2, pool.size());
+    EXPECT_EQ(5, pool[4].x);
+
+    // Paged Storage
+
+    ecs::ComponentPool<Position> paged_pool{10000};
+    paged_pool.InsertComponent(0, Position(7, 0, 0));
+    Position* first_position = &paged_pool.GetComponent(0);
+    for (ecs::entity entity = 1; entity < 10000; entity++)
+        paged_pool.InsertComponent(entity, Position(static_cast<float>(entity), 0, 0));
+    EXPECT_EQ(first_position, &paged_pool.GetComponent(0)); // growth doesn't relocate
+    EXPECT_EQ(9999, paged_pool.GetComponent(9999).x);
+    for (ecs::entity entity = 100; entity < 10000; entity++)
+        paged_pool.RemoveComponent(entity);
+    EXPECT_EQ(true, (paged_pool.capacity() <= 2 * ecs::ComponentPool<Position>::PAGE_SIZE)); // empty pages released
+    paged_pool.shrink_to_fit();
+    EXPECT_EQ(ecs::ComponentPool<Position>::PAGE_SIZE, paged_pool.capacity());
+
+    std::pmr::monotonic_buffer_resource arena{};
+    ecs::World arena_world{100, 4, &arena};
+    arena_world.RegisterComponent<Position>();
+    ecs::entity arena_entity = arena_world.CreateEntity();
+    arena_world.InsertComponent(arena_entity, Position(1, 2, 3));
+    EXPECT_EQ(&arena, arena_world.GetPool<Position>()->GetResource());
+    EXPECT_EQ(2, arena_world.GetComponent<Position>(arena_entity).y);
+
+    // View
+
+    ecs::World view_world{8, 4};
+    view_world.RegisterComponent<Position>();
+    view_world.RegisterComponent<Velocity>();
+    for (int i = 0; i < 6; i++) {
+        ecs::entity entity = view_world.CreateEntity();
+        view_world.InsertComponent(entity, Position(0, 0, 0));
+        if (i % 2 == 0) view_world.InsertComponent(entity, Velocity{1, 2, 3});
+    }
+
+    int view_count = 0;
+    for (auto [position, velocity] : view_world.View<Position, Velocity>()) {
+        position.x += velocity.x;
+        view_count++;
+    }
+    EXPECT_EQ(3, view_count);
+    view_world.View<Velocity, Position>().Each([](ecs::entity, Velocity& velocity, Position& position) {
+        position.y += velocity.y;
+    });
+    EXPECT_EQ(1, view_world.GetComponent<Position>(0).x);
+    EXPECT_EQ(2, view_world.GetComponent<Position>(0).y);
+    EXPECT_EQ(0, view_world.GetComponent<Position>(1).x);
+
+    // SoA Storage
+
+    ecs::World soa_world{100, 4};
+    soa_world.RegisterComponent<Particle>();
+    soa_world.RegisterComponent<Velocity>();
+    std::vector<ecs::entity> soa_entities(100);
+    soa_world.CreateEntities(soa_entities.size(), soa_entities);
+    for (size_t i = 0; i < soa_entities.size(); i++)
+        soa_world.InsertComponent(soa_entities[i], Particle{static_cast<float>(i), 1, 2});
+    soa_world.InsertComponents(std::span<const ecs::entity>(soa_entities).first(50), Velocity{1, 1, 1});
+    auto soa_pool = soa_world.GetPool<Particle>();
+    EXPECT_EQ(true, (std::is_same_v<ecs::pool_for<Particle>, ecs::SoAComponentPool<Particle>>));
+    for (float& x : soa_pool->Field<&Particle::x>()) x *= 2; // plain array loop
+    EXPECT_EQ(20, soa_world.GetComponent<Particle>(soa_entities[10]).get<&Particle::x>());
+    soa_world.GetComponent<Particle>(soa_entities[10]) = Particle{1, 2, 3};
+    Particle soa_particle = soa_world.GetComponent<Particle>(soa_entities[10]);
+    EXPECT_EQ(3, soa_particle.z);
+    soa_world.View<Particle, Velocity>().Each([](ecs::SoAComponentPool<Particle>::reference particle, Velocity& velocity) {
+        particle.get<1>() += velocity.y;
+    });
+    EXPECT_EQ(2, (soa_world.GetComponent<Particle>(soa_entities[0]).get<&Particle::y>()));
+    EXPECT_EQ(1, (soa_world.GetComponent<Particle>(soa_entities[50]).get<&Particle::y>()));
+    soa_world.DestroyEntity(soa_entities[0]); // last moved into the hole
+    EXPECT_EQ(99, soa_pool->size());
+    EXPECT_EQ(99 * 2, (*soa_pool)[soa_entities[99]].x);
+    EXPECT_EQ(3, soa_world.GetComponent<Particle>(soa_entities[10]).get<2>());
+    auto& soa_group = soa_world.Group<Particle, Velocity>();
+    EXPECT_EQ(49, soa_group.size());
+    soa_pool->ParallelForEach([](ecs::SoAComponentPool<Particle>::reference particle) { particle.get<2>() = 0; }, 16);
+    EXPECT_EQ(0, (*soa_pool)[soa_entities[10]].z);
+
+    // Group
+
+    auto& group = view_world.Group<Position, Velocity>();
+    EXPECT_EQ(3, group.size());
+    view_world.RemoveComponent<Velocity>(2);
+    EXPECT_EQ(2, group.size());
+    view_world.InsertComponent(5, Velocity{1, 1, 1});
+    EXPECT_EQ(3, group.size());
+    view_world.DestroyEntity(0);
+    EXPECT_EQ(2, group.size());
+    EXPECT_EQ(&group, (&view_world.Group<Position, Velocity>()));
+
+    auto velocity_pool = view_world.GetPool<Velocity>();
+    auto group_position_pool = view_world.GetPool<Position>();
+    int group_count = 0;
+    for (auto [position, velocity] : group) {
+        position.z = velocity.z;
+        group_count++;
+    }
+    EXPECT_EQ(2, group_count);
+    for (size_t i = 0; i < group.size(); i++) {
+        EXPECT_EQ(velocity_pool->GetEntityAt(i), group_position_pool->GetEntityAt(i));
+        EXPECT_EQ(group_position_pool->GetComponentAt(i).z, velocity_pool->GetComponentAt(i).z);
+    }
+    EXPECT_EQ(false, group.Contains(1));
+    EXPECT_EQ(true, group.Contains(5));
+
+    // Parallel Systems
+
+    ecs::Systems view_systems{view_world};
+    auto view_init_systems = view_systems.CreateCollectionInterface<ecs::IInitSystem>();
+    auto view_run_systems = view_systems.CreateCollectionInterface<ecs::IRunSystem>();
+    auto set_system = view_systems.CreateSystem<SetPositionSystem>();
+    auto scale_velocity_system = view_systems.CreateSystem<ScaleVelocitySystem>();
+    auto scale_position_system = view_systems.CreateSystem<ScalePositionSystem>();
+    EXPECT_EQ(false, set_system->access().Conflicts(scale_velocity_system->access()));
+    EXPECT_EQ(true, set_system->access().Conflicts(scale_position_system->access()));
+    EXPECT_EQ(true, scale_velocity_system->access().Conflicts(scale_position_system->access()));
+    for (auto system : {std::static_pointer_cast<ecs::System>(set_system), 
+        std::static_pointer_cast<ecs::System>(scale_velocity_system), std::static_pointer_cast<ecs::System>(scale_position_system)}) {
+        auto base_system = std::dynamic_pointer_cast<ecs::IRunSystem>(system);
+        view_init_systems->AddSystem(std::dynamic_pointer_cast<ecs::IInitSystem>(system));
+        view_run_systems->AddSystem(base_system);
+    }
+    ecs::ThreadPool thread_pool{3};
+    view_run_systems->SetThreadPool(&thread_pool);
+    view_init_systems->execute();
+    for (int i = 0; i < 10; i++) {
+        view_run_systems->execute();
+        for (auto [position, velocity] : view_world.Group<Position, Velocity>())
+            EXPECT_EQ(10 * velocity.x, position.x);
+    }
+#if YAECS_PROFILE
+    const ecs::SystemProfile& scale_profile = scale_velocity_system->profile();
+    EXPECT_EQ(11, scale_profile.calls); // init + 10 runs
+    EXPECT_EQ(10 * view_world.GetPool<Velocity>()->size(), scale_profile.entities);
+    EXPECT_EQ(true, (scale_profile.Min() <= scale_profile.P50() && scale_profile.P50() <= scale_profile.P99()));
+    EXPECT_EQ(true, scale_profile.P99() <= scale_profile.Max());
+    std::ostringstream trace;
+    ecs::Profiler::Shared().WriteChromeTrace(trace);
+    EXPECT_EQ(true, trace.str().find("\"name\":\"ScaleVelocitySystem\"") != std::string::npos);
+#endif
+
+    // Change Ticks
+
+    ecs::World tick_world{100, 4};
+    tick_world.RegisterComponent<Position>();
+    tick_world.RegisterComponent<Velocity>();
+    std::vector<ecs::entity> tick_entities(10);
+    tick_world.CreateEntities(tick_entities.size(), tick_entities);
+    tick_world.InsertComponents(tick_entities, Position(0, 0, 0));
+    tick_world.InsertComponents(tick_entities, Velocity{1, 1, 1});
+    EXPECT_EQ(10, (tick_world.View<ecs::Added<Position>>().size_hint()));
+    ecs::tick since = tick_world.GetTick();
+    tick_world.AdvanceTick();
+    size_t changed_count = 0;
+    tick_world.View<ecs::Changed<Position>>(since).Each([&](Position&) { changed_count++; });
+    EXPECT_EQ(0, changed_count);
+    tick_world.GetComponent<Position>(tick_entities[3]).x = 3;
+    tick_world.RemoveComponent<Position>(tick_entities[9]);
+    tick_world.InsertComponent(tick_entities[9], Position(9, 0, 0));
+    EXPECT_EQ(0, tick_world.GetComponent<const Position>(tick_entities[5]).x); // read only, not stamped
+    for (auto [position, velocity] : tick_world.View<const Position, const Velocity>()) EXPECT_EQ(1, velocity.x);
+    std::vector<ecs::entity> changed_entities;
+    tick_world.View<ecs::Changed<Position>, const Velocity>(since).Each([&](ecs::entity entity, Position&, const Velocity&) {
+        changed_entities.push_back(entity);
+    });
+    EXPECT_EQ(2, changed_entities.size());
+    size_t added_count = 0;
+    for (auto [position] : tick_world.View<ecs::Added<const Position>>(since)) { added_count++; EXPECT_EQ(9, position.x); }
+    EXPECT_EQ(1, added_count);
+
+    ecs::Systems tick_systems{tick_world};
+    auto tick_run_systems = tick_systems.CreateCollectionInterface<ecs::IRunSystem>();
+    auto moved_system = tick_systems.CreateSystem<MovedCountSystem>();
+    auto scale_tick_system = tick_systems.CreateSystem<ScalePositionSystem>();
+    tick_run_systems->AddSystem(moved_system); // consumer before producer, changes are reported in next execution
+    tick_run_systems->AddSystem(scale_tick_system);
+    tick_run_systems->execute();
+    EXPECT_EQ(10, moved_system->moved); // first run sees everything
+    tick_run_systems->execute();
+    EXPECT_EQ(10, moved_system->moved); // stamped by ScalePositionSystem after previous run
+    tick_run_systems->RemoveSystem(scale_tick_system);
+    tick_run_systems->execute();
+    EXPECT_EQ(10, moved_system->moved);
+    tick_run_systems->execute();
+    EXPECT_EQ(0, moved_system->moved);
+    tick_world.GetComponent<Position>(tick_entities[0]).y = 1;
+    tick_run_systems->execute();
+    EXPECT_EQ(1, moved_system->moved);
+    tick_run_systems->execute();
+    EXPECT_EQ(0, moved_system->moved);
+
+    // Observers
+
+    ecs::World observed_world{100, 4};
+    observed_world.RegisterComponent<Position>();
+    observed_world.RegisterComponent<Velocity>();
+    std::vector<ecs::entity> added_batch, updated_batch, removed_batch;
+    float removed_x_sum = 0;
+    observed_world.OnAdd<Position>([&](std::span<const ecs::entity> entities) {
+        added_batch.assign(entities.begin(), entities.end());
+    });
+    observed_world.OnUpdate<Position>([&](std::span<const ecs::entity> entities) {
+        updated_batch.assign(entities.begin(), entities.end());
+    });
+    observed_world.OnRemove<Position>([&](std::span<const ecs::entity> entities, std::span<Position> positions) {
+        removed_batch.assign(entities.begin(), entities.end());
+        for (auto& position : positions) removed_x_sum += position.x;
+    });
+    std::vector<ecs::entity> observed_entities(6);
+    observed_world.CreateEntities(observed_entities.size(), observed_entities);
+    observed_world.InsertComponents(std::span<const ecs::entity>(observed_entities).first(4), Position(1, 0, 0));
+    observed_world.InsertComponent(observed_entities[4], Position(2, 0, 0));
+    observed_world.InsertComponent(observed_entities[5], Velocity{});
+    EXPECT_EQ(0, added_batch.size()); // nothing until flush
+    observed_world.FlushEvents();
+    EXPECT_EQ(5, added_batch.size());
+    EXPECT_EQ(observed_entities[4], added_batch[4]);
+    observed_world.InsertComponent(observed_entities[0], Position(5, 0, 0)); // replace
+    observed_world.Patch<Position>(observed_entities[1], [](Position& position) { position.x = 10; });
+    observed_world.RemoveComponent<Position>(observed_entities[2]);
+    observed_world.DestroyEntity(observed_entities[1]);
+    ecs::CommandBuffer observed_commands;
+    observed_commands.DestroyEntity(observed_entities[4]);
+    observed_world.Flush(observed_commands);
+    EXPECT_EQ(2, updated_batch.size());
+    EXPECT_EQ(3, removed_batch.size());
+    EXPECT_EQ(observed_entities[1], removed_batch[1]);
+    EXPECT_EQ(1 + 10 + 2, removed_x_sum);
+
+    // Memory Stats
+
+    ecs::CountingMemoryResource counting_resource{};
+    {
+        ecs::World stats_world{1000, 4, &counting_resource};
+        stats_world.RegisterComponent<Position>();
+        stats_world.RegisterComponent<Particle>();
+        std::vector<ecs::entity> stats_entities(100);
+        stats_world.CreateEntities(stats_entities.size(), stats_entities);
+        stats_world.InsertComponents(stats_entities, Position(1, 1, 1));
+        stats_world.InsertComponents(std::span<const ecs::entity>(stats_entities).first(10), Particle{});
+        stats_world.DestroyEntities(std::span<const ecs::entity>(stats_entities).first(25));
+
+        ecs::WorldStats world_stats = stats_world.Stats();
+        EXPECT_EQ(75, world_stats.entities_count);
+        EXPECT_EQ(25, world_stats.free_entities);
+        EXPECT_EQ(0.25, world_stats.fragmentation);
+        EXPECT_EQ(1000 * sizeof(ecs::signature), world_stats.signature_bytes);
+        EXPECT_EQ(2, world_stats.pools.size());
+        EXPECT_EQ(ecs::TypeIndexator<Position>::value(), world_stats.pools[0].first);
+        const ecs::PoolStats& position_stats = world_stats.pools[0].second;
+        EXPECT_EQ(75, position_stats.count);
+        EXPECT_EQ(ecs::ComponentPool<Position>::PAGE_SIZE, position_stats.capacity);
+        EXPECT_EQ(1000 * sizeof(uint32_t), position_stats.sparse_bytes);
+        EXPECT_EQ(true, (position_stats.used_bytes <= position_stats.reserved_bytes));
+        EXPECT_EQ(0, world_stats.pools[1].second.count);
+        EXPECT_EQ(true, (world_stats.used_bytes <= world_stats.reserved_bytes));
+        EXPECT_EQ(true, (world_stats.reserved_bytes <= counting_resource.GetAllocatedBytes()));
+        EXPECT_EQ(true, (counting_resource.GetAllocationsCount() > 0));
+    }
+    EXPECT_EQ(0, counting_resource.GetAllocatedBytes()); // everything is returned
+    EXPECT_EQ(counting_resource.GetAllocationsCount(), counting_resource.GetDeallocationsCount());
+
+    // Tags
+
+    static_assert(std::is_same_v<ecs::pool_for<Dead>, ecs::TagComponentPool<Dead>>);
+    {
+        ecs::CountingMemoryResource tag_resource{};
+        ecs::World tag_world{100, 4, &tag_resource};
+        tag_world.RegisterComponent<Position>();
+        tag_world.RegisterComponent<Dead>();
+        std::vector<ecs::entity> tag_entities(10);
+        tag_world.CreateEntities(tag_entities.size(), tag_entities);
+        tag_world.InsertComponents(tag_entities, Position(1, 1, 1));
+        tag_world.GetPool<Dead>()->reserve(tag_entities.size());
+
+        const size_t tag_allocations = tag_resource.GetAllocationsCount();
+        const ecs::tick tag_tick = tag_world.AdvanceTick();
+        for (size_t i = 0; i < tag_entities.size(); i += 2) tag_world.AddComponent(tag_entities[i], Dead{});
+        tag_world.RemoveComponent<Dead>(tag_entities[0]);
+        tag_world.InsertComponent(tag_entities[2], Dead{}); // already tagged
+        EXPECT_EQ(tag_allocations, tag_resource.GetAllocationsCount());
+        EXPECT_EQ(4, tag_world.GetPool<Dead>()->size());
+        EXPECT_EQ(true, tag_world.ContainsComponent<Dead>(tag_entities[4]));
+        EXPECT_EQ(false, tag_world.ContainsComponent<Dead>(tag_entities[0]));
+
+        size_t tag_count = 0;
+        tag_world.View<Position, const Dead>().Each([&](Position& position, const Dead&) {
+            position.x = 0;
+            tag_count++;
+        });
+        EXPECT_EQ(4, tag_count);
+        tag_count = 0;
+        for ([[maybe_unused]] auto [dead] : tag_world.View<ecs::Added<const Dead>>(tag_tick - 1)) tag_count++;
+        EXPECT_EQ(4, tag_count);
+
+        const ecs::PoolStats tag_stats = tag_world.GetPool<Dead>()->MemoryStats();
+        EXPECT_EQ(100 * sizeof(uint32_t) + 4 * (sizeof(ecs::entity) + sizeof(ecs::tick)), tag_stats.used_bytes);
+
+        std::stringstream tag_snapshot;
+        EXPECT_EQ(true, tag_world.SaveSnapshot(tag_snapshot));
+        const std::string tag_bytes = tag_snapshot.str();
+        ecs::World tag_loaded{100, 4};
+        tag_loaded.RegisterComponent<Position>();
+        tag_loaded.RegisterComponent<Dead>();
+        EXPECT_EQ(true, tag_loaded.LoadSnapshot(std::span<const std::byte>(reinterpret_cast<const std::byte*>(tag_bytes.data()), tag_bytes.size())));
+        EXPECT_EQ(true, tag_loaded.ContainsComponent<Dead>(tag_entities[8]));
+        EXPECT_EQ(false, tag_loaded.ContainsComponent<Dead>(tag_entities[1]));
+        EXPECT_EQ(4, tag_loaded.View<const Dead>().size_hint());
+    }
+
+    // Snapshots
+
+    {
+        ecs::World saved_world{1000, 8};
+        saved_world.RegisterComponent<Position>();
+        saved_world.RegisterComponent<Velocity>();
+        saved_world.RegisterComponent<Particle>();
+        saved_world.RegisterComponent<Name>();
+        std::vector<ecs::entity> saved_entities(100);
+        saved_world.CreateEntities(saved_entities.size(), saved_entities);
+        for (size_t i = 0; i < saved_entities.size(); i++) {
+            const float value = static_cast<float>(i);
+            saved_world.InsertComponent(saved_entities[i], Position(value, value, value));
+            if (i % 2 == 0) saved_world.InsertComponent(saved_entities[i], Velocity{value, 0, 0});
+            if (i % 10 == 0) saved_world.InsertComponent(saved_entities[i], Particle{value, 1, 2});
+            if (i % 25 == 0) saved_world.InsertComponent(saved_entities[i], Name{"entity"});
+        }
+        saved_world.DestroyEntity(saved_entities[1]);
+        saved_world.DestroyEntity(saved_entities[2]);
+        saved_world.AdvanceTick();
+
+        std::stringstream snapshot{};
+        EXPECT_EQ(true, saved_world.SaveSnapshot(snapshot));
+        const std::string snapshot_bytes = snapshot.str();
+        const std::span<const std::byte> snapshot_span{reinterpret_cast<const std::byte*>(snapshot_bytes.data()), snapshot_bytes.size()};
+
+        // other registration order, group is rebuilt after load
+        ecs::World loaded_world{10, 8};
+        loaded_world.RegisterComponent<Name>();
+        loaded_world.RegisterComponent<Particle>();
+        loaded_world.RegisterComponent<Velocity>();
+        loaded_world.RegisterComponent<Position>();
+        auto& loaded_group = loaded_world.Group<Position, Velocity>();
+        ecs::entity stale = loaded_world.CreateEntity();
+        loaded_world.InsertComponent(stale, Position(-1, -1, -1));
+        EXPECT_EQ(true, loaded_world.LoadSnapshot(snapshot_span));
+
+        EXPECT_EQ(98, loaded_world.GetEntitiesCount());
+        EXPECT_EQ(false, loaded_world.ExistsEntity(saved_entities[1]));
+        EXPECT_EQ(true, loaded_world.ExistsEntity(saved_entities[3]));
+        EXPECT_EQ(98, loaded_world.GetPool<Position>()->size());
+        EXPECT_EQ(49, loaded_world.GetPool<Velocity>()->size());
+        EXPECT_EQ(49, loaded_group.size());
+        EXPECT_EQ(10, loaded_world.GetPool<Particle>()->size());
+        EXPECT_EQ(0, loaded_world.GetPool<Name>()->size()); // not trivially copyable
+        EXPECT_EQ(false, loaded_world.ContainsComponent<Name>(saved_entities[0]));
+        EXPECT_EQ(true, loaded_world.ContainsComponent<Velocity>(saved_entities[4]));
+        EXPECT_EQ(false, loaded_world.ContainsComponent<Velocity>(saved_entities[5]));
+        EXPECT_EQ(99, loaded_world.GetComponent<const Position>(saved_entities[99]).y);
+        EXPECT_EQ(40, loaded_world.GetComponent<const Velocity>(saved_entities[40]).x);
+        EXPECT_EQ(30, loaded_world.GetComponent<const Particle>(saved_entities[30]).x);
+        EXPECT_EQ(2, loaded_world.GetComponent<const Particle>(saved_entities[30]).z);
+        EXPECT_EQ(saved_world.GetTick(), loaded_world.GetTick());
+        EXPECT_EQ(false, loaded_world.GetPool<Position>()->IsChanged(saved_entities[7], saved_world.GetTick() - 1));
+        EXPECT_EQ(ecs::GetEntityIndex(saved_entities[2]), ecs::GetEntityIndex(loaded_world.CreateEntity())); // free list
+
+        // file is mapped
+        const std::string snapshot_path = "yaecs_test_snapshot.bin";
+        EXPECT_EQ(true, saved_world.SaveSnapshot(snapshot_path));
+        ecs::World mapped_world{1000, 8};
+        mapped_world.RegisterComponent<Position>();
+        mapped_world.RegisterComponent<Velocity>();
+        mapped_world.RegisterComponent<Particle>();
+        mapped_world.RegisterComponent<Name>();
+        EXPECT_EQ(true, mapped_world.LoadSnapshot(snapshot_path));
+        EXPECT_EQ(98, mapped_world.GetEntitiesCount());
+        EXPECT_EQ(true, mapped_world.ContainsComponent<Particle>(saved_entities[90]));
+        EXPECT_EQ(77, mapped_world.GetComponent<const Position>(saved_entities[77]).x);
+        std::remove(snapshot_path.c_str());
+
+        // corrupted payloads are rejected before world is changed
+        auto load_corrupted = [&](const size_t offset, const auto value) {
+            std::string corrupted = snapshot_bytes;
+            std::memcpy(corrupted.data() + offset, &value, sizeof(value));
+            return mapped_world.LoadSnapshot(std::span<const std::byte>{reinterpret_cast<const std::byte*>(corrupted.data()), corrupted.size()});
+        };
+        const size_t entities_offset = ecs::SnapshotAligned(sizeof(ecs::SnapshotHeader));
+        const size_t pool_offset = entities_offset + ecs::SnapshotAligned(100 * sizeof(ecs::entity))
+            + ecs::SnapshotAligned(100 * sizeof(ecs::signature));
+        const size_t payload_offset = ecs::SnapshotAligned(pool_offset + sizeof(ecs::SnapshotPoolHeader));
+        ecs::SnapshotPoolHeader position_header{};
+        std::memcpy(&position_header, snapshot_bytes.data() + pool_offset, sizeof(position_header));
+        const size_t velocity_offset = payload_offset + position_header.payload_bytes;
+        EXPECT_EQ(false, load_corrupted(pool_offset + offsetof(ecs::SnapshotPoolHeader, count), uint32_t{1000}));
+        EXPECT_EQ(false, load_corrupted(payload_offset, ecs::MakeEntity(5000, 0)));
+        EXPECT_EQ(false, load_corrupted(payload_offset, saved_entities[1])); // destroyed
+        EXPECT_EQ(false, load_corrupted(payload_offset + sizeof(ecs::entity), saved_entities[0])); // duplicate
+        EXPECT_EQ(false, load_corrupted(velocity_offset, position_header.type_hash)); // pool loaded twice
+        EXPECT_EQ(false, load_corrupted(offsetof(ecs::SnapshotHeader, free_entity), uint32_t{0}));
+        EXPECT_EQ(false, load_corrupted(offsetof(ecs::SnapshotHeader, entities_count), uint32_t{99}));
+        EXPECT_EQ(false, load_corrupted(offsetof(ecs::SnapshotHeader, pools_count), uint32_t{0xFFFFFFFF}));
+        EXPECT_EQ(98, mapped_world.GetEntitiesCount());
+        EXPECT_EQ(77, mapped_world.GetComponent<const Position>(saved_entities[77]).x);
+        EXPECT_EQ(true, load_corrupted(offsetof(ecs::SnapshotHeader, reserved), uint32_t{0}));
+
+        // mismatches don't change world
+        ecs::World unregistered_world{1000, 8};
+        unregistered_world.RegisterComponent<Position>();
+        ecs::entity kept = unregistered_world.CreateEntity();
+        EXPECT_EQ(false, unregistered_world.LoadSnapshot(snapshot_span));
+        EXPECT_EQ(false, unregistered_world.LoadSnapshot(snapshot_span.first(16)));
+        EXPECT_EQ(false, unregistered_world.LoadSnapshot("not_existing_snapshot.bin"));
+        EXPECT_EQ(1, unregistered_world.GetEntitiesCount());
+        EXPECT_EQ(true, unregistered_world.ExistsEntity(kept));
+    }
+
+    // Deltas
+
+    {
+        const std::byte base_bytes[6] = {std::byte{1}, std::byte{2}, std::byte{3}, std::byte{4}, std::byte{5}, std::byte{6}};
+        const std::byte changed_bytes[6] = {std::byte{1}, std::byte{7}, std::byte{3}, std::byte{4}, std::byte{5}, std::byte{6}};
+        std::vector<std::byte> encoded{};
+        ecs::DeltaEncode(base_bytes, base_bytes, encoded);
+        EXPECT_EQ(0, encoded.size()); // unchanged
+        ecs::DeltaEncode(changed_bytes, base_bytes, encoded);
+        EXPECT_EQ(3, encoded.size()); // one zero, one literal
+        std::byte mask[6] = {};
+        EXPECT_EQ(true, ecs::DeltaDecode(encoded, mask));
+        EXPECT_EQ((base_bytes[1] ^ mask[1]), changed_bytes[1]);
+        EXPECT_EQ(std::byte{0}, mask[5]);
+        EXPECT_EQ(false, ecs::DeltaDecode(encoded, std::span<std::byte>(mask).first(1)));
+
+        auto register_components = [](ecs::World& world) {
+            world.RegisterComponent<Position>();
+            world.RegisterComponent<Velocity>();
+            world.RegisterComponent<Particle>();
+            world.RegisterComponent<Name>();
+        };
+        ecs::World source_world{1000, 8};
+        register_components(source_world);
+        std::vector<ecs::entity> source_entities(200);
+        source_world.CreateEntities(source_entities.size(), source_entities);
+        for (size_t i = 0; i < source_entities.size(); i++) {
+            const float value = static_cast<float>(i);
+            source_world.InsertComponent(source_entities[i], Position(value, value, value));
+            if (i % 2 == 0) source_world.InsertComponent(source_entities[i], Velocity{1, 0, 0});
+            if (i % 10 == 0) source_world.InsertComponent(source_entities[i], Particle{value, 0, 0});
+        }
+        source_world.AdvanceTick();
+
+        std::stringstream base_stream{};
+        EXPECT_EQ(true, source_world.SaveSnapshot(base_stream));
+        const std::string base_snapshot = base_stream.str();
+        const std::span<const std::byte> base_span{reinterpret_cast<const std::byte*>(base_snapshot.data()), base_snapshot.size()};
+
+        ecs::World replica_world{1000, 8};
+        replica_world.RegisterComponent<Particle>();
+        replica_world.RegisterComponent<Position>();
+        replica_world.RegisterComponent<Velocity>();
+        replica_world.RegisterComponent<Name>();
+        auto& replica_group = replica_world.Group<Position, Velocity>();
+        size_t replica_added = 0;
+        replica_world.OnAdd<Particle>([&](std::span<const ecs::entity> added) { replica_added += added.size(); });
+        EXPECT_EQ(true, replica_world.LoadSnapshot(base_span));
+        EXPECT_EQ(100, replica_group.size());
+
+        // nothing changed, delta has only headers
+        std::stringstream empty_delta{};
+        EXPECT_EQ(true, source_world.SaveDelta(base_span, empty_delta));
+        const size_t empty_delta_size = empty_delta.str().size();
+        EXPECT_EQ(true, (empty_delta_size < 300));
+
+        // step of simulation
+        for (size_t i = 0; i < 20; i++) source_world.GetComponent<Position>(source_entities[i]).x += 0.5f;
+        source_world.GetComponent<Particle>(source_entities[10]).get<&Particle::y>() = 3;
+        source_world.RemoveComponent<Velocity>(source_entities[4]);
+        source_world.InsertComponent(source_entities[5], Velocity{2, 0, 0});
+        source_world.DestroyEntity(source_entities[6]);
+        source_world.DestroyEntity(source_entities[20]);
+        const ecs::entity spawned = source_world.CreateEntity(); // recycles index of source_entities[20]
+        source_world.InsertComponent(spawned, Position(-1, -1, -1));
+        source_world.InsertComponent(spawned, Particle{-1, -1, -1});
+        source_world.InsertComponent(source_entities[7], Name{"not copied"});
+        source_world.AdvanceTick();
+
+        std::stringstream delta_stream{};
+        EXPECT_EQ(true, source_world.SaveDelta(base_span, delta_stream));
+        const std::string delta = delta_stream.str();
+        const std::span<const std::byte> delta_span{reinterpret_cast<const std::byte*>(delta.data()), delta.size()};
+        EXPECT_EQ(true, (delta.size() < base_snapshot.size() / 4));
+
+        EXPECT_EQ(true, replica_world.ApplyDelta(delta_span));
+        replica_world.FlushEvents();
+        EXPECT_EQ(source_world.GetEntitiesCount(), replica_world.GetEntitiesCount());
+        EXPECT_EQ(false, replica_world.ExistsEntity(source_entities[6]));
+        EXPECT_EQ(false, replica_world.ExistsEntity(source_entities[20]));
+        EXPECT_EQ(true, replica_world.ExistsEntity(spawned));
+        EXPECT_EQ(-1, replica_world.GetComponent<const Position>(spawned).z);
+        EXPECT_EQ(-1, replica_world.GetComponent<const Particle>(spawned).y);
+        EXPECT_EQ(1, replica_added);
+        EXPECT_EQ(3, replica_world.GetComponent<const Particle>(source_entities[10]).y);
+        EXPECT_EQ(false, replica_world.ContainsComponent<Velocity>(source_entities[4]));
+        EXPECT_EQ(2, replica_world.GetComponent<const Velocity>(source_entities[5]).x);
+        EXPECT_EQ(false, replica_world.ContainsComponent<Name>(source_entities[7]));
+        EXPECT_EQ(source_world.GetPool<Velocity>()->size(), replica_group.size());
+        for (auto entity : source_entities) {
+            if (!source_world.ExistsEntity(entity)) continue;
+            EXPECT_EQ(source_world.GetComponent<const Position>(entity).x, replica_world.GetComponent<const Position>(entity).x);
+            EXPECT_EQ(source_world.ContainsComponent<Velocity>(entity), replica_world.ContainsComponent<Velocity>(entity));
+            EXPECT_EQ(source_world.ContainsComponent<Particle>(entity), replica_world.ContainsComponent<Particle>(entity));
+        }
+        EXPECT_EQ(ecs::GetEntityIndex(source_world.CreateEntity()), ecs::GetEntityIndex(replica_world.CreateEntity()));
+
+        // rollback: base and delta restore the step
+        ecs::World rollback_world{1000, 8};
+        register_components(rollback_world);
+        EXPECT_EQ(true, rollback_world.LoadSnapshot(base_span));
+        EXPECT_EQ(true, rollback_world.ApplyDelta(delta_span));
+        EXPECT_EQ(10.5f, rollback_world.GetComponent<const Position>(source_entities[10]).x);
+        EXPECT_EQ(false, rollback_world.ApplyDelta(delta_span.first(delta_span.size() - 1)));
+        EXPECT_EQ(false, rollback_world.ApplyDelta(base_span));
+
+        // world isn't in base state: patched components don't exist, so nothing is applied
+        ecs::World fresh_world{1000, 8};
+        register_components(fresh_world);
+        EXPECT_EQ(false, fresh_world.ApplyDelta(delta_span));
+        EXPECT_EQ(0, fresh_world.GetEntitiesCount());
+        std::string corrupted = delta;
+        const uint32_t pools_count = 0xFFFFFFFF;
+        std::memcpy(corrupted.data() + offsetof(ecs::DeltaHeader, pools_count), &pools_count, sizeof(pools_count));
+        EXPECT_EQ(false, rollback_world.ApplyDelta({reinterpret_cast<const std::byte*>(corrupted.data()), corrupted.size()}));
+    }
+
+    // Static World
+
+    {
+        using StaticWorld = ecs::StaticWorld<Position, Velocity, Particle>;
+        static_assert(StaticWorld::INDEX<Velocity> == 1);
+        static_assert(StaticWorld::INDEX<const Particle> == 2);
+
+        StaticWorld static_world{100};
+        std::vector<ecs::entity> static_entities(10);
+        static_world.CreateEntities(static_entities.size(), static_entities);
+        static_world.InsertComponents(std::span<const ecs::entity>(static_entities), Position(1, 1, 1));
+        for (size_t i = 0; i < static_entities.size(); i += 2) static_world.AddComponent(static_entities[i], Velocity{2, 0, 0});
+        static_world.InsertComponent(static_entities[3], Particle{3, 3, 3});
+
+        EXPECT_EQ(10, static_world.GetEntitiesCount());
+        EXPECT_EQ(true, static_world.ContainsComponent<Velocity>(static_entities[4]));
+        EXPECT_EQ(false, static_world.ContainsComponent<Velocity>(static_entities[3]));
+        EXPECT_EQ(3, static_world.GetComponent<const Particle>(static_entities[3]).y);
+
+        size_t static_count = 0;
+        static_world.View<Position, const Velocity>().Each([&](Position& position, const Velocity& velocity) {
+            position.x += velocity.x;
+            static_count++;
+        });
+        EXPECT_EQ(5, static_count);
+        EXPECT_EQ(3, static_world.GetComponent<const Position>(static_entities[0]).x);
+        EXPECT_EQ(1, static_world.GetComponent<const Position>(static_entities[1]).x);
+
+        const ecs::tick static_tick = static_world.AdvanceTick();
+        static_world.GetComponent<Position>(static_entities[1]).y = 5;
+        static_count = 0;
+        for ([[maybe_unused]] auto [position] : static_world.View<ecs::Changed<const Position>>(static_tick - 1)) static_count++;
+        EXPECT_EQ(1, static_count);
+
+        auto& static_group = static_world.Group<Position, Velocity>();
+        EXPECT_EQ(5, static_group.size());
+        static_world.RemoveComponent<Velocity>(static_entities[0]);
+        EXPECT_EQ(4, static_group.size());
+        static_world.DestroyEntity(static_entities[2]);
+        EXPECT_EQ(3, static_group.size());
+        EXPECT_EQ(false, static_world.ExistsEntity(static_entities[2]));
+        EXPECT_EQ(9, static_world.GetPool<Position>().size());
+        EXPECT_EQ(ecs::GetEntityIndex(static_entities[2]), ecs::GetEntityIndex(static_world.CreateEntity()));
+    }
+
+    // Hierarchy
+
+    {
+        ecs::World hierarchy_world{100, 4};
+        hierarchy_world.RegisterComponent<Position>();
+        std::vector<ecs::entity> nodes(6);
+        hierarchy_world.CreateEntities(nodes.size(), nodes);
+        hierarchy_world.InsertComponents(std::span<const ecs::entity>(nodes), Position(1, 0, 0));
+        const ecs::entity d = nodes[0], c = nodes[1], b = nodes[2], a = nodes[3], root = nodes[4], other = nodes[5];
+        hierarchy_world.SetParent(d, c);
+        hierarchy_world.SetParent(c, a);
+        hierarchy_world.SetParent(b, root);
+        hierarchy_world.SetParent(a, root);
+        EXPECT_EQ(root, hierarchy_world.GetParent(a));
+        EXPECT_EQ(ecs::NULL_ENTITY, hierarchy_world.GetParent(root));
+        EXPECT_EQ(ecs::NULL_ENTITY, hierarchy_world.GetParent(other));
+
+        // parents are before children, so world positions are one forward pass
+        auto hierarchy_pool = hierarchy_world.GetPool<ecs::Hierarchy>();
+        hierarchy_world.SortHierarchy();
+        std::vector<ecs::entity> sorted_nodes(hierarchy_pool->begin_ent_active(), hierarchy_pool->end_ent_active());
+        EXPECT_EQ(true, (sorted_nodes == std::vector<ecs::entity>{root, a, b, c, d}));
+        std::vector<float> world_x(nodes.size(), 0);
+        for (size_t i = 0; i < hierarchy_pool->size(); i++) {
+            const ecs::entity node = hierarchy_pool->GetEntityAt(i);
+            const ecs::entity parent = hierarchy_pool->GetComponentAt(i).parent;
+            world_x[ecs::GetEntityIndex(node)] = hierarchy_world.GetComponent<const Position>(node).x
+                + (parent == ecs::NULL_ENTITY ? 0 : world_x[ecs::GetEntityIndex(parent)]);
+        }
+        EXPECT_EQ(4, world_x[ecs::GetEntityIndex(d)]);
+        EXPECT_EQ(2, world_x[ecs::GetEntityIndex(b)]);
+
+        hierarchy_world.SetParent(c, b);
+        hierarchy_world.SetParent(d, ecs::NULL_ENTITY);
+        EXPECT_EQ(0, (*hierarchy_pool)[a].children);
+        EXPECT_EQ(b, hierarchy_world.GetParent(c));
+        size_t children_count = 0;
+        hierarchy_world.EachChild(root, [&](ecs::entity) { children_count++; });
+        EXPECT_EQ(2, children_count);
+        hierarchy_world.SortHierarchy(ecs::HierarchyOrder::DepthFirst);
+        sorted_nodes.assign(hierarchy_pool->begin_ent_active(), hierarchy_pool->end_ent_active());
+        EXPECT_EQ(true, (sorted_nodes == std::vector<ecs::entity>{root, a, b, c, d}));
+
+        // subtrees are destroyed with their roots
+        hierarchy_world.DestroyEntity(b);
+        EXPECT_EQ(false, hierarchy_world.ExistsEntity(c));
+        EXPECT_EQ(1, (*hierarchy_pool)[root].children);
+        EXPECT_EQ(4, hierarchy_world.GetEntitiesCount());
+        const ecs::entity destroyed[] = {root, d};
+        hierarchy_world.DestroyEntities(destroyed);
+        EXPECT_EQ(false, hierarchy_world.ExistsEntity(a));
+        EXPECT_EQ(1, hierarchy_world.GetEntitiesCount());
+        EXPECT_EQ(0, hierarchy_pool->size());
+        EXPECT_EQ(1, hierarchy_world.GetPool<Position>()->size());
+    }
+
+    // Sorting
+
+    {
+        // permutation with cycles (0 1 2) and (3 4) needs 5 - 2 swaps
+        std::vector<int> sort_values{1, 2, 0, 4, 3};
+        size_t swaps = 0;
+        auto sort_less = [&](size_t a, size_t b) { return sort_values[a] < sort_values[b]; };
+        auto sort_swap = [&](size_t a, size_t b) { std::swap(sort_values[a], sort_values[b]); swaps++; };
+        ecs::SortIndexes(0, sort_values.size(), sort_less, sort_swap);
+        EXPECT_EQ(true, (sort_values == std::vector<int>{0, 1, 2, 3, 4}));
+        EXPECT_EQ(3, swaps);
+        ecs::SortIndexes(0, sort_values.size(), sort_less, sort_swap);
+        EXPECT_EQ(3, swaps); // sorted range isn't touched
+        std::swap(sort_values[1], sort_values[2]);
+        ecs::SortIndexes(0, sort_values.size(), sort_less, sort_swap, ecs::SortAlgorithm::Insertion);
+        EXPECT_EQ(true, (sort_values == std::vector<int>{0, 1, 2, 3, 4}));
+        EXPECT_EQ(4, swaps);
+
+        ecs::World sort_world{100, 4};
+        sort_world.RegisterComponent<Position>();
+        sort_world.RegisterComponent<Velocity>();
+        sort_world.RegisterComponent<Particle>();
+        std::vector<ecs::entity> sort_entities(10);
+        sort_world.CreateEntities(sort_entities.size(), sort_entities);
+        for (size_t i = 0; i < sort_entities.size(); i++) {
+            const float x = static_cast<float>((i * 7) % 10);
+            sort_world.AddComponent(sort_entities[i], Position(x, 0, 0));
+            sort_world.AddComponent(sort_entities[i], Particle{0, -x, 0});
+            if (i % 3 != 0) sort_world.AddComponent(sort_entities[sort_entities.size() - 1 - i], Velocity{1, 0, 0});
+        }
+
+        auto sort_pool = sort_world.GetPool<Position>();
+        sort_pool->Sort([](const Position& a, const Position& b) { return a.x < b.x; });
+        for (size_t i = 0; i < sort_pool->size(); i++) EXPECT_EQ(static_cast<float>(i), sort_pool->GetComponentAt(i).x);
+        auto particle_pool = sort_world.GetPool<Particle>();
+        particle_pool->Sort([](const Particle& a, const Particle& b) { return a.y < b.y; }, ecs::SortAlgorithm::Insertion);
+        EXPECT_EQ(-9, std::as_const(*particle_pool).GetComponentAt(0).y);
+
+        // velocities follow positions, so view walks both pools forward
+        sort_world.SortAs<Velocity, Position>();
+        auto velocity_pool = sort_world.GetPool<Velocity>();
+        for (size_t i = 1; i < velocity_pool->size(); i++)
+            EXPECT_EQ(true, (sort_pool->GetIndex(velocity_pool->GetEntityAt(i - 1)) < sort_pool->GetIndex(velocity_pool->GetEntityAt(i))));
+        particle_pool->SortAs(*sort_pool);
+        EXPECT_EQ(true, (particle_pool->GetEntityAt(3) == sort_pool->GetEntityAt(3)));
+
+        // members of group stay at front of owned pools and aligned
+        auto& sort_group = sort_world.Group<Position, Velocity>();
+        sort_world.Sort<Position>([](const Position& a, const Position& b) { return a.x > b.x; });
+        EXPECT_EQ(6, sort_group.size());
+        for (size_t i = 0; i < sort_pool->size(); i++) {
+            EXPECT_EQ((i < sort_group.size()), sort_group.Contains(sort_pool->GetEntityAt(i)));
+            if (i > 0 && i != sort_group.size())
+                EXPECT_EQ(true, (sort_pool->GetComponentAt(i - 1).x > sort_pool->GetComponentAt(i).x));
+            if (i < sort_group.size()) EXPECT_EQ(sort_pool->GetEntityAt(i), velocity_pool->GetEntityAt(i));
+        }
+        sort_world.SortAs<Position, Particle>();
+        for (size_t i = 0; i < sort_group.size(); i++) EXPECT_EQ(sort_pool->GetEntityAt(i), velocity_pool->GetEntityAt(i));
+    }
+
+    // Sharded World
+
+    {
+        ecs::ShardedWorld sharded_world{3, 100, 4};
+        sharded_world.SetThreadPool(&thread_pool);
+        sharded_world.RegisterComponent<Position>();
+        sharded_world.RegisterComponent<Particle>();
+        sharded_world.RegisterComponent<Name>();
+
+        std::vector<ecs::ShardedWorld::Handle> handles;
+        for (uint32_t i = 0; i < 12; i++) {
+            auto handle = sharded_world.CreateEntity(i % 3);
+            sharded_world.AddComponent(handle, Position(static_cast<float>(i), 0, 0));
+            if (i % 2 == 0) sharded_world.AddComponent(handle, Particle{static_cast<float>(i), 1, 2});
+            if (i == 4) sharded_world.AddComponent(handle, Name{"moved"});
+            handles.push_back(handle);
+        }
+        EXPECT_EQ(12, sharded_world.GetEntitiesCount());
+        EXPECT_EQ(4, sharded_world.GetShard(1).GetEntitiesCount());
+
+        // the same systems run in every shard
+        for (uint32_t shard = 0; shard < sharded_world.GetShardsCount(); shard++) {
+            auto& shard_systems = sharded_world.GetSystems(shard);
+            auto shard_init_systems = shard_systems.CreateCollectionInterface<ecs::IInitSystem>();
+            auto shard_run_systems = shard_systems.CreateCollectionInterface<ecs::IRunSystem>();
+            auto shard_system = shard_systems.CreateSystem<PositionSystem>();
+            shard_init_systems->AddSystem(shard_system);
+            shard_run_systems->AddSystem(shard_system);
+            shard_run_systems->SetThreadPool(&thread_pool);
+        }
+        sharded_world.ExecuteCollectionInterface<ecs::IInitSystem>();
+        sharded_world.ExecuteCollectionInterface<ecs::IRunSystem>();
+        sharded_world.ExecuteCollectionInterface<ecs::IRunSystem>();
+        EXPECT_EQ(6, sharded_world.GetComponent<const Position>(handles[4]).x);
+
+        // partition by x: [0, 8) -> shard 0, [8, 12) -> shard 1, rest -> shard 2
+        sharded_world.MigrateBy<Position>([](const Position& position) {
+            return position.x < 8 ? 0u : position.x < 12 ? 1u : 2u;
+        });
+        sharded_world.Migrate(handles[4], 2);
+        auto migrated = sharded_world.Sync();
+        EXPECT_EQ(9, migrated.size());
+        EXPECT_EQ(12, sharded_world.GetEntitiesCount());
+        EXPECT_EQ(6, sharded_world.GetShard(0).GetEntitiesCount());
+        EXPECT_EQ(4, sharded_world.GetShard(1).GetEntitiesCount());
+        EXPECT_EQ(2, sharded_world.GetShard(2).GetEntitiesCount());
+
+        // handles[4] was queued twice, first migration moved it to shard 0, second found it stale
+        size_t moved_count = 0;
+        for (auto migration : migrated) {
+            if (migration.to.entity == ecs::NULL_ENTITY) {
+                EXPECT_EQ(true, (migration.from == handles[4]));
+                continue;
+            }
+            EXPECT_EQ(false, sharded_world.ExistsEntity(migration.from));
+            EXPECT_EQ(true, sharded_world.ExistsEntity(migration.to));
+            moved_count++;
+            if (migration.from == handles[4]) {
+                EXPECT_EQ(0, migration.to.shard);
+                EXPECT_EQ("moved", sharded_world.GetComponent<const Name>(migration.to).value);
+                EXPECT_EQ(true, sharded_world.ContainsComponent<Particle>(migration.to));
+                EXPECT_EQ(2, sharded_world.GetComponent<const Particle>(migration.to).z);
+            }
+        }
+        EXPECT_EQ(8, moved_count);
+        EXPECT_EQ(true, sharded_world.ExistsEntity(handles[3]));
+        EXPECT_EQ(0, sharded_world.Sync().size());
+
+        std::atomic<size_t> query_count{0};
+        float query_sum = 0;
+        sharded_world.Each<Position>([&](ecs::ShardedWorld::Handle handle, const Position& position) {
+            EXPECT_EQ(true, (handle.shard == (position.x < 8 ? 0u : position.x < 12 ? 1u : 2u)));
+            query_sum += position.x;
+        });
+        EXPECT_EQ(2 * 12 + 66, query_sum);
+        sharded_world.ParallelEach<Position, Particle>([&](const Position&, const Particle&) { query_count++; });
+        EXPECT_EQ(6, query_count.load());
+    }
+    {
+        // hierarchy is per shard: migrated parent leaves it, children stay as roots
+        ecs::ShardedWorld sharded_world{2, 16, 4};
+        auto other = sharded_world.CreateEntity(1);
+        sharded_world.GetShard(1).SetParent(sharded_world.CreateEntity(1).entity, other.entity);
+        sharded_world.RegisterComponent<Position>();
+        auto parent = sharded_world.CreateEntity(0);
+        auto child1 = sharded_world.CreateEntity(0);
+        auto child2 = sharded_world.CreateEntity(0);
+        sharded_world.AddComponent(parent, Position(1, 2, 3));
+        sharded_world.GetShard(0).SetParent(child1.entity, parent.entity);
+        sharded_world.GetShard(0).SetParent(child2.entity, parent.entity);
+        sharded_world.Migrate(parent, 1);
+        auto migrated = sharded_world.Sync();
+        EXPECT_EQ(1, migrated.size());
+        EXPECT_EQ(true, sharded_world.ExistsEntity(child1));
+        EXPECT_EQ(true, sharded_world.ExistsEntity(child2));
+        EXPECT_EQ(ecs::NULL_ENTITY, sharded_world.GetShard(0).GetParent(child1.entity));
+        EXPECT_EQ(ecs::NULL_ENTITY, sharded_world.GetShard(0).GetParent(child2.entity));
+        EXPECT_EQ(3, sharded_world.GetComponent<const Position>(migrated[0].to).z);
+        EXPECT_EQ(false, sharded_world.ContainsComponent<ecs::Hierarchy>(migrated[0].to));
+        EXPECT_EQ(5, sharded_world.GetEntitiesCount());
+    }
+
+    // Parallel Iteration
+
+    ecs::World parallel_world{20000, 4};
+    parallel_world.RegisterComponent<Position>();
+    parallel_world.RegisterComponent<Velocity>();
+    for (int i = 0; i < 20000; i++) {
+        ecs::entity entity = parallel_world.CreateEntity();
+        parallel_world.InsertComponent(entity, Position(0, 0, 0));
+        if (i % 3 == 0) parallel_world.InsertComponent(entity, Velocity{1, 0, 0});
+    }
+    // chunks stamp changed ticks, so they are split on cache lines of ticks too
+    EXPECT_EQ(0, (ecs::ComponentPool<std::string>::PARALLEL_ALIGNMENT * sizeof(ecs::tick) % ecs::CACHE_LINE_SIZE));
+    EXPECT_EQ(0, (ecs::SoAComponentPool<Particle>::PARALLEL_ALIGNMENT * sizeof(ecs::tick) % ecs::CACHE_LINE_SIZE));
+    using ParallelView = ecs::View<Position, const Velocity>;
+    EXPECT_EQ(0, (ParallelView::PARALLEL_ALIGNMENT * sizeof(ecs::tick) % ecs::CACHE_LINE_SIZE));
+    EXPECT_EQ(0, (ParallelView::PARALLEL_ALIGNMENT * sizeof(Position) % ecs::CACHE_LINE_SIZE));
+    EXPECT_EQ(0, (ParallelView::PARALLEL_ALIGNMENT * sizeof(Velocity) % ecs::CACHE_LINE_SIZE));
+    auto parallel_positions = parallel_world.GetPool<Position>();
+    parallel_positions->ParallelForEach([](Position& position) { position.y += 1; }, 256, thread_pool);
+    parallel_positions->ParallelForEach([](ecs::entity entity, Position& position) { 
+        position.z = static_cast<float>(ecs::GetEntityIndex(entity)); 
+    }, 256, thread_pool);
+    parallel_world.View<Position, Velocity>().ParallelEach([](Position& position, Velocity& velocity) {
+        position.x += velocity.x;
+    }, 256, thread_pool);
+    parallel_world.Group<Velocity, Position>().ParallelEach([](Velocity& velocity, Position& position) {
+        position.x += velocity.x;
+    }, 256, thread_pool);
+    for (int i = 0; i < 20000; i++) {
+        auto& position = parallel_positions->GetComponent(ecs::MakeEntity(i, 0));
+        EXPECT_EQ(1, position.y);
+        EXPECT_EQ(i, position.z);
+        EXPECT_EQ((i % 3 == 0 ? 2.f : 0.f), position.x);
+    }
+
+    // Command Buffer
+
+    ecs::World command_world{16, 4};
+    command_world.RegisterComponent<Position>();
+    command_world.RegisterComponent<Velocity>();
+    ecs::CommandBuffer command_buffer;
+    ecs::entity pending = command_buffer.CreateEntity();
+    EXPECT_EQ(true, ecs::CommandBuffer::IsPending(pending));
+    command_buffer.InsertComponent(pending, Velocity{1, 2, 3});
+    command_buffer.InsertComponent(pending, Position(4, 5, 6));
+    command_buffer.RemoveComponent<Position>(pending);
+    command_buffer.InsertComponent(pending, std::string(100, 'x')); // non trivial component
+    command_world.RegisterComponent<std::string>();
+    EXPECT_EQ(5, command_buffer.size());
+    command_world.Flush(command_buffer);
+    EXPECT_EQ(true, command_buffer.empty());
+    EXPECT_EQ(1, command_world.GetEntitiesCount());
+    ecs::entity flushed = ecs::MakeEntity(0, 0);
+    EXPECT_EQ(true, command_world.ContainsComponent<Velocity>(flushed));
+    EXPECT_EQ(false, command_world.ContainsComponent<Position>(flushed));
+    EXPECT_EQ(100, command_world.GetComponent<std::string>(flushed).size());
+
+    // move assignment destroys recorded components of target
+    auto command_payload = std::make_shared<int>(1);
+    ecs::CommandBuffer moved_commands;
+    moved_commands.InsertComponent(moved_commands.CreateEntity(), command_payload);
+    command_buffer.InsertComponent(command_buffer.CreateEntity(), Velocity{1, 1, 1});
+    moved_commands = std::move(command_buffer);
+    EXPECT_EQ(1, command_payload.use_count());
+    EXPECT_EQ(2, moved_commands.size());
+    EXPECT_EQ(true, command_buffer.empty());
+    moved_commands.clear();
+
+    ecs::Systems command_systems{command_world};
+    auto command_run_systems = command_systems.CreateCollectionInterface<ecs::IRunSystem>();
+    auto command_init_systems = command_systems.CreateCollectionInterface<ecs::IInitSystem>();
+    auto spawn_system = command_systems.CreateSystem<SpawnSystem>();
+    command_init_systems->AddSystem(spawn_system);
+    command_run_systems->AddSystem(spawn_system);
+    command_init_systems->execute();
+    command_run_systems->execute();
+    EXPECT_EQ(false, command_world.ExistsEntity(flushed));
+    EXPECT_EQ(1, command_world.GetEntitiesCount());
+    EXPECT_EQ(1, command_world.GetPool<Position>()->size());
+
+    // Batch
+
+    ecs::World batch_world{1000, 4};
+    batch_world.RegisterComponent<Position>();
+    batch_world.RegisterComponent<Velocity>();
+    ecs::entity first_batch_entity = batch_world.CreateEntity();
+    batch_world.DestroyEntity(first_batch_entity);
+    std::vector<ecs::entity> batch_entities(1000);
+    batch_world.CreateEntities(batch_entities.size(), batch_entities);
+    EXPECT_EQ(1000, batch_world.GetEntitiesCount());
+    EXPECT_EQ(1, ecs::GetEntityVersion(batch_entities[0]));
+    EXPECT_EQ(999, ecs::GetEntityIndex(batch_entities[999]));
+    std::vector<Position> batch_positions(1000, Position(1, 2, 3));
+    batch_world.InsertComponents<Position>(batch_entities, batch_positions);
+    batch_world.InsertComponents(std::span<const ecs::entity>(batch_entities).first(500), Velocity{1, 1, 1});
+    auto& batch_group = batch_world.Group<Position, Velocity>();
+    EXPECT_EQ(1000, batch_world.GetPool<Position>()->size());
+    EXPECT_EQ(500, batch_group.size());
+    batch_world.DestroyEntities(std::span<const ecs::entity>(batch_entities).subspan(250, 500));
+    EXPECT_EQ(500, batch_world.GetEntitiesCount());
+    EXPECT_EQ(500, batch_world.GetPool<Position>()->size());
+    EXPECT_EQ(250, batch_world.GetPool<Velocity>()->size());
+    EXPECT_EQ(250, batch_group.size());
+
     // Systems
 
     ecs::Systems systems{world};
@@ -84,10 +1133,11 @@ int main(int argc, char* argv[]) {
 
     systems.ExecuteCollectionInterface<ecs::IInitSystem>();
 
-    EXPECT_EQ(0, position_pool->GetComponent(entity1).x);
+    EXPECT_EQ(false, position_pool->ContainsComponent(entity1));
     EXPECT_EQ(0, position_pool->GetComponent(entity2).x);
-    EXPECT_EQ(0, position_pool->GetComponent(entity3).x);
-    for (auto it = position_pool->begin_comp_all(); it != position_pool->end_comp_all(); ++it) {
+    EXPECT_EQ(false, position_pool->ContainsComponent(entity3));
+    EXPECT_EQ(1, position_pool->size());
+    for (auto it = position_pool->begin_comp_active(); it != position_pool->end_comp_active(); ++it) {
         auto& component = *it;
         std::cout << component.x;
     }
@@ -99,10 +1149,8 @@ int main(int argc, char* argv[]) {
     runSystems->execute();
     runSystems->execute();
 
-    EXPECT_EQ(0, position_pool->GetComponent(entity1).x);
     EXPECT_EQ(5, position_pool->GetComponent(entity2).x);
-    EXPECT_EQ(0, position_pool->GetComponent(entity3).x);
-    for (auto it = position_pool->begin_comp_all(); it != position_pool->end_comp_all(); ++it) {
+    for (auto it = position_pool->begin_comp_active(); it != position_pool->end_comp_active(); ++it) {
         auto& component = *it;
         std::cout << component.x;
     }